@@ -0,0 +1,245 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "cache.hpp"
+#include "cone.hpp"
+#include "memory.hpp"
+#include "moments.hpp"
+#include "tables.hpp"
+
+// Forms of a family for each n, made on first use. They do not depend on the inequality, so all queries of a
+// batch share them and only subtract their own target. Concurrent searches share the table too, so it is
+// only read and written under the lock, and memory pressure may empty it at any time; forms are returned
+// as copies, which every search makes anyway.
+template <size_t K> class FormTable {
+public:
+  using Forms = std::array<Symbol, K>;
+
+  explicit FormTable(std::function<Forms(size_t n)> make) : make(std::move(make)) {
+    trimmer = add_trimmer([this] {
+      std::lock_guard<std::mutex> guard(lock);
+      table.clear();
+    });
+  }
+  FormTable(const FormTable &) = delete;
+  FormTable &operator=(const FormTable &) = delete;
+  ~FormTable() { remove_trimmer(trimmer); }
+
+  Forms operator[](size_t n) {
+    relieve_memory();
+    std::unique_lock<std::mutex> guard(lock);
+    if (auto it = table.find(n); it != table.end())
+      return it->second;
+    guard.unlock();
+    Forms forms = make(n);
+    guard.lock();
+    table.emplace(n, forms);
+    return forms;
+  }
+
+private:
+  std::function<Forms(size_t n)> make;
+  std::map<size_t, Forms> table;
+  std::mutex lock;
+  size_t trimmer;
+};
+
+// Everything a batch needs to answer the queries a + b*alpha >= 0 of one type. The target (a, b) is
+// subtracted from the first and the last form, as the single solves do, which `solve` runs: n (the index
+// of the forms), m and the certificate of one query, searched without shared forms.
+template <size_t K> struct Family {
+  using Found = std::tuple<size_t, size_t, std::array<Fraction, K>>;
+
+  std::function<std::array<Symbol, K>(size_t n)> forms;
+  std::function<size_t(size_t limit)> count;   // Values of n a search up to `limit` tries, 0 to count - 1
+  std::function<Moments<K>()> moments;         // For the asymmetric search, empty if it is not supported
+  Constant alpha;
+  std::function<size_t(long double)> estimate; // Starting n of a galloping search, may be empty
+  std::function<std::string(size_t n, size_t m, const std::array<Fraction, K> &cert)> format;
+  std::function<Found(const Fraction &a, const Fraction &b, size_t limit, const SearchOptions &opt,
+                      bool asymmetric)>
+      solve;
+};
+
+// Function of the certificate for a + b*alpha >= 0 found within `limit`, for one type
+using BatchSolver = std::function<std::string(const Fraction &a, const Fraction &b, size_t limit)>;
+
+// How every query of a batch is searched
+struct BatchSettings {
+  size_t limit = 64;
+  SearchOptions opt;
+  bool asymmetric = false;
+  std::string tables; // Directory of the tables from extend_table(), "" for none
+  std::shared_ptr<ResultCache> cache; // Shared by every type, none if null
+  std::chrono::duration<double> timeout{0}; // Deadline of each query, none if 0
+};
+
+// Forms of a family made on first use, or read from the type's table below its size if there is one
+template <size_t K>
+std::shared_ptr<FormTable<K>> family_forms(const std::string &type, const Family<K> &family,
+                                           const BatchSettings &settings) {
+  std::function<std::array<Symbol, K>(size_t n)> make = family.forms;
+  if (!settings.tables.empty()) {
+    auto table = std::make_shared<MappedForms<K>>(table_path(settings.tables, type), type);
+    if (table->size() > 0)
+      make = [table, make](size_t n) { return n < table->size() ? (*table)(n) : make(n); };
+  }
+  return std::make_shared<FormTable<K>>(make);
+}
+
+// Solver answering every query of a type from the same forms, or moments in the asymmetric search. Each
+// query takes the same path as a single solve with search_direct(), which the linear scan agrees with.
+// The linear scan of the families with a linear auxiliary polynomial looks the smallest n up in a
+// ConeIndex instead, grown by doubling until it has an answer, so only that n is solved exactly.
+// Forms below the size of the type's table, if there is one, are read from it. Queries may run
+// concurrently: they look up the index together but grow it, or use the moments, one at a time.
+//
+// With a cache, results are kept under the query divided by the GCD of its terms: k*a + k*b*alpha >= 0
+// for k > 0 is certified at the same n by k times the certificate, which is also what its own search
+// finds, as the solution at a given n is unique. The asymmetric search picks the shortest certificate,
+// which depends on the scale, so its queries are kept as they are. `type` must be canonical, as in the
+// cache keys.
+template <size_t K>
+BatchSolver batch_solver(const std::string &type, const Family<K> &family, const BatchSettings &settings) {
+  const SearchOptions opt = settings.opt;
+  const bool asymmetric = settings.asymmetric;
+  if (asymmetric && !family.moments)
+    throw not_implemented("Asymmetric search for this type");
+  const auto forms = family_forms(type, family, settings);
+  const auto mu = asymmetric ? std::make_shared<Moments<K>>(family.moments()) : nullptr;
+  const bool indexed = K == 2 && !asymmetric && opt.mode == Search::linear;
+  const auto index = indexed ? std::make_shared<ConeIndex>() : nullptr;
+  const auto guard = std::make_shared<std::shared_mutex>(); // Over the index and the moments
+  using Found = typename Family<K>::Found;
+  auto search = [=](const Fraction &a, const Fraction &b, size_t limit) -> Found {
+    const std::string none = "No solution found within the limit of " + std::to_string(limit);
+    if (asymmetric) {
+      precheck(a, b, family.alpha, nullptr, opt);
+      Form<K> target;
+      target[0] = a, target[K - 1] = b;
+      std::unique_lock<std::shared_mutex> writing(*guard);
+      auto attempt = [&](size_t n, size_t m) { return attempt_window(*mu, n, m, target, opt); };
+      if (auto found = cost_ordered_search(attempt, certificate_size<K>, limit))
+        return *found;
+      throw std::domain_error(none);
+    }
+    const size_t hint = precheck(a, b, family.alpha, family.estimate, opt), count = family.count(limit);
+    auto attempt = [&](size_t n) {
+      std::array<Symbol, K> eq = (*forms)[n];
+      eq[0] -= Symbol(a), eq[K - 1] -= Symbol(b);
+      return certify_forms(eq, opt);
+    };
+    if constexpr (K == 2) {
+      if (index && !(a.is_zero() && b.is_zero())) {
+        std::shared_lock<std::shared_mutex> reading(*guard);
+        std::optional<size_t> n = index->smallest(a, b);
+        reading.unlock();
+        if (!n) {
+          std::unique_lock<std::shared_mutex> writing(*guard);
+          while (!(n = index->smallest(a, b)) && index->size() < count)
+            index->extend(std::min(count, 2 * index->size() + 1), [&](size_t k) { return (*forms)[k]; });
+        }
+        if (!n || *n >= count)
+          throw std::domain_error(none);
+        note_attempt(*n);
+        if (auto cert = attempt(*n))
+          return {*n, *n, *cert};
+        // Only queries outside A + B*alpha > 0 get here, and the scan below finds no n for them either
+      }
+    }
+    if (count > 0)
+      if (auto found = search_direct(attempt, count - 1, opt, hint))
+        return {found->first, found->first, found->second};
+    throw std::domain_error(none);
+  };
+  const std::shared_ptr<ResultCache> cache = settings.cache;
+  const std::string mode = asymmetric ? "asymmetric" : opt.mode == Search::gallop ? "gallop" : "linear";
+  return [=](const Fraction &a, const Fraction &b, size_t limit) {
+    if (!cache || (a.is_zero() && b.is_zero())) {
+      auto [n, m, cert] = search(a, b, limit);
+      return family.format(n, m, cert);
+    }
+    // (a, b) = scale * (A, B) with A and B integers, coprime unless the search is asymmetric
+    Ray q = to_ray(a, b);
+    BigInt g = asymmetric ? 1_big : Fraction::find_gcd(q[0], q[1]);
+    if (g.is_negative())
+      g = -g;
+    q[0] /= g, q[1] /= g;
+    const Fraction scale(g, a.denominator * b.denominator);
+    const std::string key =
+        type + " " + q[1].to_str() + " " + q[0].to_str() + " " + std::to_string(limit) + " " + mode;
+    std::array<Fraction, K> cert;
+    if (auto hit = cache->find(key); hit && hit->cert.size() == K) {
+      for (size_t i = 0; i < K; ++i)
+        cert[i] = hit->cert[i] * scale;
+      return family.format(hit->n, hit->m, cert);
+    }
+    const auto [n, m, found] = search(a, b, limit);
+    CachedResult result{n, m, {}};
+    for (const Fraction &c : found)
+      result.cert.push_back(c / scale);
+    cache->insert(key, result);
+    return family.format(n, m, found);
+  };
+}
+
+// Functions of the certificates of one query, each call returning the next one, nothing past the last
+using CertificateGenerator = std::function<std::optional<std::string>()>;
+
+// Every certificate for a + b*alpha >= 0 up to `limit`, from the smallest n, or the smallest degree
+// n + m in the asymmetric search, found only as they are asked for. The generator keeps the forms and
+// the position of the search between calls, so taking k certificates costs one search up to the k-th;
+// its first certificate is the answer of a linear search. The sign of the inequality is certified here,
+// once.
+template <size_t K>
+CertificateGenerator certificate_generator(const std::string &type, const Family<K> &family,
+                                           const Fraction &a, const Fraction &b, size_t limit,
+                                           const BatchSettings &settings) {
+  const SearchOptions opt = settings.opt;
+  if (settings.asymmetric && !family.moments)
+    throw not_implemented("Asymmetric search for this type");
+  precheck(a, b, family.alpha, nullptr, opt);
+  if (settings.asymmetric) {
+    auto mu = std::make_shared<Moments<K>>(family.moments());
+    Form<K> target;
+    target[0] = a, target[K - 1] = b;
+    auto attempt = [mu, target, opt](size_t n, size_t m) { return attempt_window(*mu, n, m, target, opt); };
+    using Stream = DegreeStream<decltype(attempt), decltype(&certificate_size<K>)>;
+    auto stream = std::make_shared<Stream>(attempt, certificate_size<K>, limit);
+    return [stream, family]() -> std::optional<std::string> {
+      if (auto found = stream->next())
+        return family.format(std::get<0>(*found), std::get<1>(*found), std::get<2>(*found));
+      return std::nullopt;
+    };
+  }
+  auto forms = family_forms(type, family, settings);
+  auto attempt = [forms, a, b, opt](size_t n) {
+    std::array<Symbol, K> eq = (*forms)[n];
+    eq[0] -= Symbol(a), eq[K - 1] -= Symbol(b);
+    return certify_forms(eq, opt);
+  };
+  const size_t count = family.count(limit);
+  if (count == 0)
+    return []() -> std::optional<std::string> { return std::nullopt; };
+  auto stream = std::make_shared<LinearStream<decltype(attempt)>>(attempt, count - 1, opt.threads);
+  return [stream, family]() -> std::optional<std::string> {
+    if (auto found = stream->next())
+      return family.format(found->first, found->first, found->second);
+    return std::nullopt;
+  };
+}
+
+#endif // BATCH_HPP
@@ -0,0 +1,116 @@
+#include "equation.hpp"
+#include "maths.hpp"
+#include "modular.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Usage: benchmark [<max n=1024>]
+//
+// Times how long the cached tables in maths.hpp take to reach n = 16, 32, ..., max n. The tables only
+// ever grow, so each time is cumulative: it is the cost of building the table for n from scratch.
+//
+// Then checks try_modular_solve() against try_bareiss() on random regular and singular systems of 2 to 16
+// unknowns, timing both, and fails if they disagree.
+
+// Extends a table with build(n) for doubling n and prints the elapsed time
+template <typename Build> void benchmark(const std::string &name, Build build, size_t max_n) {
+  using namespace std;
+  using clock = chrono::steady_clock;
+  cout << name << endl;
+  const auto start = clock::now();
+  for (size_t n = 16; n <= max_n; n *= 2) {
+    build(n);
+    cout << "  n = " << n << ": " << chrono::duration<double, milli>(clock::now() - start).count() << " ms"
+         << endl;
+  }
+}
+
+// Random integer of up to `digits` decimal digits, of either sign
+BigInt random_integer(std::mt19937_64 &rng, size_t digits) {
+  std::string s = rng() % 2 ? "-" : "";
+  for (size_t i = 0, n = rng() % digits + 1; i < n; ++i)
+    s += char('0' + rng() % 10);
+  return BigInt(s.c_str());
+}
+
+enum class System { regular, singular, unlucky };
+
+// Random augmented n x (n + 1) system. A singular one has its last row a combination of two others; an
+// unlucky one starts triangular with the largest word prime dividing its determinant, so the modular
+// solver has to replace that prime, and adding multiples of rows then hides the triangle.
+std::vector<std::vector<BigInt>> random_system(std::mt19937_64 &rng, size_t n, size_t digits, System kind) {
+  std::vector<std::vector<BigInt>> m(n, std::vector<BigInt>(n + 1));
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j <= n; ++j)
+      m[i][j] = kind == System::unlucky && j < i ? BigInt() : random_integer(rng, digits);
+  if (kind == System::singular) {
+    const BigInt a = random_integer(rng, 3), b = random_integer(rng, 3);
+    for (size_t j = 0; j <= n; ++j)
+      m[n - 1][j] = m[0][j] * a + m[n - 2][j] * b;
+  }
+  if (kind == System::unlucky) {
+    m[0][0] = BigInt((uintmax_t)word_primes(1)[0]) * random_integer(rng, 3);
+    for (size_t i = 0; i < n; ++i)
+      m[i][i] = m[i][i].is_zero() ? BigInt(1) : m[i][i];
+    for (size_t i = 1; i < n; ++i) {
+      const BigInt k = random_integer(rng, 3);
+      for (size_t j = 0; j <= n; ++j)
+        m[i][j] += m[i - 1][j] * k;
+    }
+  }
+  return m;
+}
+
+// Whether both solvers find the same solution, or both find none; D is only fixed up to sign
+bool same_solution(const std::optional<std::pair<std::vector<BigInt>, BigInt>> &a,
+                   const std::optional<std::pair<std::vector<BigInt>, BigInt>> &b) {
+  if (!a || !b)
+    return !a && !b;
+  const BigInt &D = a->second, &E = b->second;
+  if (D.is_zero() || (D - E).is_zero() == (D + E).is_zero())
+    return false;
+  for (size_t i = 0; i < a->first.size(); ++i)
+    if (!(a->first[i] * E - b->first[i] * D).is_zero())
+      return false;
+  return true;
+}
+
+// Solves the same random systems with try_bareiss() and try_modular_solve(), printing the time of each
+bool check_modular() {
+  using namespace std;
+  using clock = chrono::steady_clock;
+  mt19937_64 rng(2024);
+  cout << "try_modular_solve vs try_bareiss" << endl;
+  for (size_t digits : {20, 200})
+    for (size_t n : {2, 3, 6, 10, 16}) {
+      double bareiss_ms = 0, modular_ms = 0;
+      for (System kind : {System::regular, System::singular, System::unlucky})
+        for (int round = 0; round < 3; ++round) {
+          const auto m = random_system(rng, n, digits, kind);
+          auto start = clock::now();
+          const auto expected = try_bareiss(m);
+          bareiss_ms += chrono::duration<double, milli>(clock::now() - start).count();
+          start = clock::now();
+          const auto found = try_modular_solve(m, round + 1);
+          modular_ms += chrono::duration<double, milli>(clock::now() - start).count();
+          if (!same_solution(expected, found) || (kind == System::singular) != !expected) {
+            cout << "  n = " << n << ", " << digits << " digits: solutions differ" << endl;
+            return false;
+          }
+        }
+      cout << "  n = " << n << ", " << digits << " digits: bareiss " << bareiss_ms << " ms, modular "
+           << modular_ms << " ms" << endl;
+    }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t max_n = argc > 1 ? std::stoul(argv[1]) : 1024;
+  benchmark("factorial(64n)", [](size_t n) { factorial(64 * n); }, max_n);
+  benchmark("zeta(n)", [](size_t n) { zeta(n); }, max_n);
+  benchmark("beta(n + 1)", [](size_t n) { beta(n + 1); }, max_n);
+  return check_modular() ? 0 : 1;
+}
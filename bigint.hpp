@@ -31,6 +31,9 @@ SOFTWARE.
 #define BIGINT_MINI_HPP
 
 #include "bigint_header.hpp"
+#include "cancel.hpp"
+#include "memory.hpp"
+#include <cmath>
 #include <stdexcept>
 
 namespace BigIntMiniNS {
@@ -50,7 +53,7 @@ protected:
   typedef int32_t carry_t;
   typedef uint32_t ucarry_t;
   int sign;
-  std::vector<base_t> v;
+  std::vector<base_t, CountingAllocator<base_t>> v;
   typedef BigIntMini BigInt_t;
   template <typename _Tx, typename _Ty> static inline void carry(_Tx &add, _Ty &baseval, _Tx newval) {
     add += newval;
@@ -140,10 +143,49 @@ protected:
     trim();
     return *this;
   }
+  // Adds |c| * |d| to the magnitude, or subtracts it and flips the sign if that passes zero, one row of
+  // the schoolbook product at a time. Larger products go through raw_mul_karatsuba() and a temporary.
+  BigInt_t &add_product(const BigInt_t &c, const BigInt_t &d, bool same_sign) {
+    if (std::min(c.size(), d.size()) > BIGINT_MUL_THRESHOLD) {
+      BigInt_t cd;
+      cd.raw_mul_karatsuba(c, d);
+      return same_sign ? raw_add(cd) : raw_sub(cd);
+    }
+    const size_t length = std::max(v.size(), c.size() + d.size()) + 1;
+    v.resize(length);
+    carry_t out = 0; // Borrows past the top limb
+    for (size_t i = 0; i < c.size(); i++) {
+      const carry_t cv = c.v[i];
+      carry_t add = 0;
+      size_t k = i;
+      if (same_sign) {
+        for (size_t j = 0; j < d.size(); j++, k++)
+          carry(add, v[k], (carry_t)v[k] + cv * (carry_t)d.v[j]);
+        for (; add && k < length; k++)
+          carry(add, v[k], (carry_t)v[k]);
+      } else {
+        for (size_t j = 0; j < d.size(); j++, k++)
+          borrow(add, v[k], (carry_t)v[k] - cv * (carry_t)d.v[j]);
+        for (; add && k < length; k++)
+          borrow(add, v[k], (carry_t)v[k]);
+      }
+      out += add;
+    }
+    if (out < 0) {
+      // The limbs hold the result plus COMPRESS_MOD^length, as in raw_sub()
+      sign = -sign;
+      carry_t add = 1;
+      for (size_t i = 0; i < v.size(); i++)
+        carry(add, v[i], (carry_t)(COMPRESS_MOD - v[i] - 1));
+    }
+    trim();
+    return *this;
+  }
   // Karatsuba algorithm
   BigInt_t &raw_mul_karatsuba(const BigInt_t &a, const BigInt_t &b) {
     if (std::min(a.size(), b.size()) <= BIGINT_MUL_THRESHOLD)
       return raw_mul(a, b);
+    check_cancelled(); // Each level above the threshold is long enough to be worth a look at the clock
     BigInt_t ah, al, bh, bl, h, m;
     size_t split =
         std::max(std::min((a.size() + 1) / 2, b.size() - 1), std::min(a.size() - 1, (b.size() + 1) / 2));
@@ -234,6 +276,7 @@ protected:
     } else if (b.size() <= BIGINT_DIVIDEDIV_THRESHOLD) {
       return raw_div(a, b, r);
     }
+    check_cancelled();
     size_t base = (b.size() + 1) / 2;
     if (a.size() <= base * 3) {
       base = b.size() / 2;
@@ -265,6 +308,10 @@ protected:
     return *this;
   }
   BigInt_t &raw_dividediv(const BigInt_t &a, const BigInt_t &b, BigInt_t &r) {
+    if (a.raw_less(b)) { // Also keeps a.size() - b.size() below from wrapping around
+      r = a;
+      return set((uintmax_t)0);
+    }
     if (b.size() <= BIGINT_DIVIDEDIV_THRESHOLD) {
       raw_div(a, b, r);
       return *this;
@@ -422,6 +469,20 @@ public:
     return d;
   }
 
+  // *this = a * b + c * d and *this = a * b - c * d, building the first product in this number's storage
+  // and adding the second one into it, so below the Karatsuba threshold neither needs a temporary. Neither
+  // may alias *this.
+  BigInt_t &set_mul_add(const BigInt_t &a, const BigInt_t &b, const BigInt_t &c, const BigInt_t &d) {
+    raw_mul_karatsuba(a, b);
+    sign = a.sign * b.sign;
+    return add_product(c, d, c.sign * d.sign == sign);
+  }
+  BigInt_t &set_mul_sub(const BigInt_t &a, const BigInt_t &b, const BigInt_t &c, const BigInt_t &d) {
+    raw_mul_karatsuba(a, b);
+    sign = a.sign * b.sign;
+    return add_product(c, d, c.sign * d.sign != sign);
+  }
+
   BigInt_t &operator+=(const BigInt_t &b) { return *this = *this + b; }
   BigInt_t &operator-=(const BigInt_t &b) { return *this = *this - b; }
   BigInt_t &operator*=(const BigInt_t &b) { return *this = *this * b; }
@@ -452,6 +513,54 @@ public:
     return out;
   }
 
+  // Number of decimal digits of the absolute value
+  size_t digits() const {
+    size_t top = 1;
+    for (base_t t = v.back(); t >= 10; t /= 10)
+      ++top;
+    return (v.size() - 1) * COMPRESS_DIGITS + top;
+  }
+
+  // Nearest long double from the leading limbs, within 2^-62 of the value relatively; it overflows to
+  // infinity above about 10^4932, callers check digits() first
+  long double to_long_double() const {
+    const size_t top = std::min<size_t>(v.size(), 6);
+    long double r = 0;
+    for (size_t i = v.size(); i-- > v.size() - top;)
+      r = r * COMPRESS_MOD + v[i];
+    if (v.size() > top)
+      r *= std::pow((long double)COMPRESS_MOD, (long double)(v.size() - top));
+    return sign < 0 ? -r : r;
+  }
+
+  // Decimal logarithm of the absolute value, also beyond the range of to_long_double(); requires non-zero
+  long double log10_abs() const {
+    const size_t top = std::min<size_t>(v.size(), 6);
+    long double r = 0;
+    for (size_t i = v.size(); i-- > v.size() - top;)
+      r = r * COMPRESS_MOD + v[i];
+    return std::log10(r) + (long double)((v.size() - top) * COMPRESS_DIGITS);
+  }
+
+  // Value modulo p in [0, p), for 0 < p < 2^32
+  uint64_t residue(uint64_t p) const {
+    uint64_t r = 0;
+    for (size_t i = v.size(); i-- > 0;)
+      r = (r * COMPRESS_MOD + v[i]) % p;
+    return sign < 0 && r ? p - r : r;
+  }
+
+  // Base-10^4 limbs of the absolute value, least significant first, for serialization
+  const std::vector<base_t, CountingAllocator<base_t>> &limbs() const { return v; }
+
+  // Sets the value from limbs() and get_sign() of another number
+  BigInt_t &set_limbs(int s, const base_t *first, size_t count) {
+    v.assign(first, first + count);
+    if (v.empty())
+      v.push_back(0);
+    return sign = s < 0 ? -1 : 1, trim(), *this;
+  }
+
   int get_sign() const { return sign; }
   bool is_one() const { return v.size() == 1 && v[0] == 1 && sign == 1; }
   bool is_minus_one() const { return v.size() == 1 && v[0] == 1 && sign == -1; }
@@ -460,7 +569,31 @@ public:
   explicit operator bool() const { return !is_zero(); }
 
   std::string to_str() const { return out_dec(); }
+
+  // Sign of a * b - c * d. When the products differ in size by more than the rounding of log10_abs(), the
+  // leading limbs decide without multiplying; only products this close are formed in full.
+  friend int cmp_products(const BigInt_t &a, const BigInt_t &b, const BigInt_t &c, const BigInt_t &d) {
+    const int left = a.is_zero() || b.is_zero() ? 0 : a.sign * b.sign;
+    const int right = c.is_zero() || d.is_zero() ? 0 : c.sign * d.sign;
+    if (left != right || left == 0)
+      return left < right ? -1 : left > right;
+    const long double gap = a.log10_abs() + b.log10_abs() - c.log10_abs() - d.log10_abs();
+    if (std::fabs(gap) > 1e-9L)
+      return gap > 0 ? left : -left;
+    BigInt_t ab, cd;
+    ab.raw_mul_karatsuba(a, b), cd.raw_mul_karatsuba(c, d);
+    return ab.raw_eq(cd) ? 0 : ab.raw_less(cd) ? -left : left;
+  }
 };
+
+BigIntMini mul_add(const BigIntMini &a, const BigIntMini &b, const BigIntMini &c, const BigIntMini &d) {
+  BigIntMini r;
+  return r.set_mul_add(a, b, c, d), r;
+}
+BigIntMini mul_sub(const BigIntMini &a, const BigIntMini &b, const BigIntMini &c, const BigIntMini &d) {
+  BigIntMini r;
+  return r.set_mul_sub(a, b, c, d), r;
+}
 } // namespace BigIntMiniNS
 
 using BigInt = BigIntMiniNS::BigIntMini;
@@ -0,0 +1,200 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fraction.hpp"
+#include "memory.hpp"
+#include "tables.hpp"
+
+// A certificate found by a search: x^n * (1-x)^m times the polynomial with these coefficients
+struct CachedResult {
+  size_t n, m;
+  std::vector<Fraction> cert;
+};
+
+struct CacheStats {
+  uint64_t hits = 0, disk_hits = 0, misses = 0;
+};
+
+// Results of solved queries by key, kept in memory up to `entries` of them and, if `dir` is not empty, in
+// one file per key there up to `bytes` in total. Both drop the least recently used results first; files
+// are ordered by modification time, which a hit refreshes, so the order survives between runs. Files are
+// named by a hash of the key and start with the key itself, so a collision is only a miss. Results in
+// memory are all dropped under memory pressure, those on disk are kept.
+class ResultCache {
+public:
+  explicit ResultCache(size_t entries, std::string dir = "", uint64_t bytes = 0)
+      : entries(entries), dir(std::move(dir)), bytes(bytes) {
+    if (!this->dir.empty())
+      scan();
+    trimmer = add_trimmer([this] {
+      std::lock_guard<std::mutex> guard(lock);
+      memory.clear(), recent.clear();
+    });
+  }
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+  ~ResultCache() { remove_trimmer(trimmer); }
+
+  std::optional<CachedResult> find(const std::string &key) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto it = memory.find(key); it != memory.end()) {
+      recent.splice(recent.end(), recent, it->second);
+      ++counts.hits;
+      return it->second->second;
+    }
+    if (!dir.empty())
+      if (auto result = load(key)) {
+        remember(key, *result);
+        ++counts.hits, ++counts.disk_hits;
+        return result;
+      }
+    ++counts.misses;
+    return std::nullopt;
+  }
+
+  void insert(const std::string &key, const CachedResult &result) {
+    std::lock_guard<std::mutex> guard(lock);
+    remember(key, result);
+    if (!dir.empty())
+      store(key, result);
+  }
+
+  CacheStats stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return counts;
+  }
+
+private:
+  using Entry = std::pair<std::string, CachedResult>;
+  using File = std::pair<std::string, uint64_t>; // Name and size
+
+  size_t entries;
+  std::string dir;
+  uint64_t bytes;
+  std::list<Entry> recent; // Least recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> memory;
+  std::list<File> files; // Least recently used first
+  std::unordered_map<std::string, std::list<File>::iterator> on_disk;
+  uint64_t used = 0;
+  CacheStats counts;
+  mutable std::mutex lock;
+  size_t trimmer;
+
+  static std::string file_name(const std::string &key) {
+    char name[24];
+    const uint64_t hash = fnv1a((const unsigned char *)key.data(), key.size());
+    std::snprintf(name, sizeof(name), "%016" PRIx64 ".res", hash);
+    return name;
+  }
+
+  void remember(const std::string &key, const CachedResult &result) {
+    if (auto it = memory.find(key); it != memory.end()) {
+      it->second->second = result;
+      recent.splice(recent.end(), recent, it->second);
+      return;
+    }
+    memory.emplace(key, recent.insert(recent.end(), {key, result}));
+    for (; recent.size() > entries; recent.pop_front())
+      memory.erase(recent.front().first);
+  }
+
+  // Takes the files already in the directory, oldest first
+  void scan() {
+    namespace fs = std::filesystem;
+    fs::create_directories(dir);
+    std::vector<std::pair<fs::file_time_type, std::pair<std::string, uint64_t>>> found;
+    for (const auto &file : fs::directory_iterator(dir))
+      if (file.is_regular_file() && file.path().extension() == ".res")
+        found.push_back({file.last_write_time(), {file.path().filename().string(), file.file_size()}});
+    std::sort(found.begin(), found.end());
+    for (auto &[time, file] : found)
+      touch(file.first, file.second);
+    evict();
+  }
+
+  // Marks a file as the most recently used one, with its current size
+  void touch(const std::string &name, uint64_t size) {
+    if (auto it = on_disk.find(name); it != on_disk.end()) {
+      used -= it->second->second;
+      files.erase(it->second);
+    }
+    on_disk[name] = files.insert(files.end(), {name, size});
+    used += size;
+  }
+
+  void forget(const std::string &name) {
+    if (auto it = on_disk.find(name); it != on_disk.end()) {
+      used -= it->second->second;
+      files.erase(it->second);
+      on_disk.erase(it);
+    }
+  }
+
+  void evict() {
+    while (used > bytes && !files.empty()) {
+      const std::string name = files.front().first;
+      std::error_code ignored; // Another process may have removed it already
+      std::filesystem::remove(dir + "/" + name, ignored);
+      forget(name);
+    }
+  }
+
+  // The file of a key holds the key, then n and m, then the coefficients, one per line. Files written by
+  // other processes sharing the directory are found too.
+  std::optional<CachedResult> load(const std::string &key) {
+    const std::string name = file_name(key), path = dir + "/" + name;
+    std::ifstream file(path);
+    if (!file) {
+      forget(name);
+      return std::nullopt;
+    }
+    std::string line;
+    CachedResult result;
+    if (!std::getline(file, line) || line != key || !(file >> result.n >> result.m))
+      return std::nullopt;
+    try {
+      for (std::string c; file >> c;)
+        result.cert.push_back(Fraction(c));
+    } catch (const std::exception &) {
+      return std::nullopt; // Damaged, so the result is searched for and the file replaced
+    }
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    const uint64_t size = std::filesystem::file_size(path, error);
+    touch(name, error ? 0 : size);
+    return result;
+  }
+
+  void store(const std::string &key, const CachedResult &result) {
+    const std::string name = file_name(key), path = dir + "/" + name, temp = path + ".tmp";
+    std::string out = key + "\n" + std::to_string(result.n) + " " + std::to_string(result.m) + "\n";
+    for (const Fraction &c : result.cert)
+      out += c.to_string() + "\n";
+    {
+      std::ofstream file(temp, std::ios::trunc);
+      if (!file.write(out.data(), out.size()))
+        return; // A cache that cannot be written only costs the next run a search
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0)
+      return;
+    touch(name, out.size());
+    evict();
+  }
+};
+
+#endif // CACHE_HPP
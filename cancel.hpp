@@ -0,0 +1,83 @@
+#ifndef CANCEL_HPP
+#define CANCEL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "except.hpp"
+#include "memory.hpp"
+
+// Deadline of a solve, checked cooperatively. Searches report each n they try, and the loops that can run
+// long, the searches and the recursive BigInt multiplication and division, check the token of their
+// thread; once the deadline has passed or cancel() was called, the check throws timed_out with the
+// furthest point the search reached.
+class CancelToken {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit CancelToken(Clock::duration timeout) : deadline(Clock::now() + timeout) {}
+
+  void cancel() { cancelled = true; }
+
+  bool expired() const { return cancelled.load(std::memory_order_relaxed) || Clock::now() >= deadline; }
+
+  // Records an attempt at n, or at the pair (n, m) if m is given, keeping the one of largest degree
+  void reached(size_t n, size_t m = SIZE_MAX) {
+    std::lock_guard<std::mutex> guard(lock);
+    const size_t degree = m == SIZE_MAX ? n : n + m;
+    if (attempts++ == 0 || degree > furthest_degree)
+      furthest_degree = degree, furthest_n = n, furthest_m = m;
+  }
+
+  void check() const {
+    if (!expired())
+      return;
+    std::lock_guard<std::mutex> guard(lock);
+    if (attempts == 0)
+      throw timed_out("Timed out before the first attempt");
+    throw timed_out("Timed out after " + std::to_string(attempts) + " attempts, the furthest at n = " +
+                    std::to_string(furthest_n) +
+                    (furthest_m == SIZE_MAX ? "" : ", m = " + std::to_string(furthest_m)));
+  }
+
+private:
+  Clock::time_point deadline;
+  std::atomic<bool> cancelled{false};
+  mutable std::mutex lock;
+  size_t attempts = 0, furthest_degree = 0, furthest_n = 0, furthest_m = SIZE_MAX;
+};
+
+// Token of the solve running on this thread, null if it has no deadline
+thread_local CancelToken *current_cancel = nullptr;
+
+// Makes `token` the token of this thread while in scope; threads a search starts install the token of
+// the thread that started them
+class CancelScope {
+public:
+  explicit CancelScope(CancelToken *token) : previous(current_cancel) { current_cancel = token; }
+  CancelScope(const CancelScope &) = delete;
+  CancelScope &operator=(const CancelScope &) = delete;
+  ~CancelScope() { current_cancel = previous; }
+
+private:
+  CancelToken *previous;
+};
+
+void check_cancelled() {
+  if (current_cancel)
+    current_cancel->check();
+}
+
+// Records an attempt at n, or at the pair (n, m), and stops there if the solve is out of time. Between
+// attempts is also where caches are given back under memory pressure.
+void note_attempt(size_t n, size_t m = SIZE_MAX) {
+  relieve_memory();
+  if (current_cancel)
+    current_cancel->reached(n, m), current_cancel->check();
+}
+
+#endif // CANCEL_HPP
@@ -0,0 +1,134 @@
+#ifndef CONE_HPP
+#define CONE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "maths.hpp"
+#include "symbol.hpp"
+
+// A direction (A, B) of queries a + b*alpha >= 0 with a = A and b = B, scaled to integers
+using Ray = std::array<BigInt, 2>;
+
+// Ray along (x, y) for fractions, scaled by the positive product of their denominators
+Ray to_ray(const Fraction &x, const Fraction &y) {
+  return {x.numerator * y.denominator, y.numerator * x.denominator};
+}
+
+BigInt dot(const Ray &u, const Ray &v) { return u[0] * v[0] + u[1] * v[1]; }
+
+// Positive if v is counterclockwise from u by less than a half turn, negative if clockwise, 0 if parallel
+int turn(const Ray &u, const Ray &v) { return sign_of(mul_sub(u[0], v[1], u[1], v[0])); }
+
+// Smallest n at which the linear families certify a query, for all queries at once. At a given n the
+// forms make (A, B) a linear image of the coefficients (a, b), so the solution is a fixed linear map of
+// the query and each condition a >= 0, a + b >= 0 is a half-plane through the origin: the certified
+// queries form a cone, the directions between two rays. Every such cone lies in the open half-plane
+// A + B*alpha > 0, where the angle orders directions totally, so the sorted rays of all cones cut it into
+// pieces on which the smallest n is constant, found by one binary search.
+class ConeIndex {
+public:
+  // Values of n indexed so far, 0 to size() - 1
+  size_t size() const { return count; }
+
+  // Indexes n up to `last` - 1 as well, where forms(n) are A and B in the symbols a and b
+  template <typename Forms> void extend(size_t last, const Forms &forms) {
+    try {
+      for (; count < last; ++count)
+        check_cancelled(), add(count, forms(count));
+    } catch (...) {
+      build(); // Keeps the cones added so far, as size() counts them, if a deadline stops the loop
+      throw;
+    }
+    build();
+  }
+
+  // Smallest indexed n whose cone contains (A, B) != 0, or nothing if there is none. Exact for queries in
+  // the open half-plane A + B*alpha > 0, which holds for every true inequality; the answer for any other
+  // query is meaningless but harmless, as those are certified at no n.
+  std::optional<size_t> smallest(const Fraction &A, const Fraction &B) const {
+    const Ray q = to_ray(A, B);
+    const size_t i = position(q);
+    size_t n = SIZE_MAX;
+    if (i < rays.size() && turn(rays[i], q) == 0)
+      n = pieces[2 * i];
+    else if (i > 0 && i < rays.size())
+      n = pieces[2 * i - 1];
+    return n == SIZE_MAX ? std::nullopt : std::make_optional(n);
+  }
+
+private:
+  // Certified queries at n: the directions from `lo` counterclockwise to `hi`
+  struct Cone {
+    size_t n;
+    Ray lo, hi;
+  };
+
+  size_t count = 0;
+  std::vector<Cone> cones;
+  std::vector<Ray> rays;      // Edges of all cones sorted counterclockwise, without repeats
+  std::vector<size_t> pieces; // Smallest n on rays[i] at 2i and strictly between rays[i] and rays[i + 1] at
+                              // 2i + 1, SIZE_MAX for none
+
+  // A = p a + q b and B = r a + s b give a = (s A - q B) / D and b = (p B - r A) / D with D = p s - q r, so
+  // a >= 0 and a + b >= 0 are half-planes with normals (s, -q) and (s - r, p - q) times the sign of D.
+  // Singular systems certify nothing.
+  void add(size_t n, const std::array<Symbol, 2> &forms) {
+    const Fraction p = forms[0].get_coefficient('a'), q = forms[0].get_coefficient('b');
+    const Fraction r = forms[1].get_coefficient('a'), s = forms[1].get_coefficient('b');
+    const Fraction D = p * s - q * r;
+    if (D.is_zero())
+      return;
+    std::array<Ray, 2> l{to_ray(s, -q), to_ray(s - r, p - q)}, edge;
+    if (D.is_negative())
+      for (Ray &x : l)
+        x[0] = -x[0], x[1] = -x[1];
+    for (size_t i = 0; i < 2; ++i) {
+      // The edge on which l[i] vanishes, turned towards the side where l[1 - i] holds
+      edge[i] = {-l[i][1], l[i][0]};
+      if (sign_of(dot(l[1 - i], edge[i])) < 0)
+        edge[i][0] = -edge[i][0], edge[i][1] = -edge[i][1];
+    }
+    if (turn(edge[0], edge[1]) < 0)
+      std::swap(edge[0], edge[1]);
+    cones.push_back({n, std::move(edge[0]), std::move(edge[1])});
+  }
+
+  size_t position(const Ray &x) const {
+    auto before = [](const Ray &r, const Ray &y) { return turn(r, y) > 0; };
+    return std::lower_bound(rays.begin(), rays.end(), x, before) - rays.begin();
+  }
+
+  // Each cone covers the pieces from its first edge to its last. Painting the cones by increasing n, with
+  // each piece skipped once painted, leaves the smallest n on every piece.
+  void build() {
+    rays.clear();
+    for (const Cone &cone : cones)
+      rays.push_back(cone.lo), rays.push_back(cone.hi);
+    std::sort(rays.begin(), rays.end(), [](const Ray &u, const Ray &v) { return turn(u, v) > 0; });
+    rays.erase(std::unique(rays.begin(), rays.end(),
+                           [](const Ray &u, const Ray &v) { return turn(u, v) == 0; }),
+               rays.end());
+    pieces.assign(rays.empty() ? 0 : 2 * rays.size() - 1, SIZE_MAX);
+    std::vector<size_t> next(pieces.size() + 1); // Union-find of the first unpainted piece from each one
+    for (size_t i = 0; i < next.size(); ++i)
+      next[i] = i;
+    auto unpainted = [&](size_t i) {
+      while (next[i] != i)
+        i = next[i] = next[next[i]];
+      return i;
+    };
+    for (const Cone &cone : cones) {
+      const size_t last = 2 * position(cone.hi);
+      for (size_t i = unpainted(2 * position(cone.lo)); i <= last; i = unpainted(i))
+        pieces[i] = cone.n, next[i] = i + 1;
+    }
+  }
+};
+
+#endif // CONE_HPP
@@ -0,0 +1,182 @@
+#ifndef CONSTANTS_HPP
+#define CONSTANTS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "fraction.hpp"
+#include "maths.hpp"
+
+// Real number x with lo <= x * 10^digits <= hi
+struct Enclosure {
+  BigInt lo, hi;
+  size_t digits;
+};
+
+// Enclosure of a constant with the given number of digits after the decimal point
+using Constant = std::function<Enclosure(size_t digits)>;
+
+BigInt ten_power(size_t n) { return fast_pow(10_big, n); }
+
+// floor(a / b) and ceil(a / b) for b > 0, as BigInt division truncates towards zero
+BigInt floor_div(const BigInt &a, const BigInt &b) {
+  BigInt q = a / b;
+  if (a.is_negative() && !(q * b == a))
+    q -= 1_big;
+  return q;
+}
+
+BigInt ceil_div(const BigInt &a, const BigInt &b) {
+  BigInt q = a / b;
+  if (!a.is_negative() && !(q * b == a))
+    q += 1_big;
+  return q;
+}
+
+// Drops digits from an enclosure, rounding its bounds outwards
+Enclosure rescale(const Enclosure &x, size_t digits) {
+  if (digits >= x.digits)
+    return x;
+  const BigInt scale = ten_power(x.digits - digits);
+  return {floor_div(x.lo, scale), ceil_div(x.hi, scale), digits};
+}
+
+// Term a(k)/b(k) * p(0)...p(k) / (q(0)...q(k)) of a hypergeometric series, with b, q > 0
+struct SeriesTerm {
+  BigInt a, b, p, q;
+};
+
+// Partial sum S = T / (B * Q) of a series over k in [lo, hi), with P and Q the products of p and q.
+// Splitting the range in halves keeps the operands of each level balanced, which is where Karatsuba
+// multiplication pays off, instead of adding one small term to a huge sum at a time.
+struct Split {
+  BigInt P, Q, B, T;
+};
+
+template <typename Term> Split binary_split(size_t lo, size_t hi, const Term &term) {
+  if (hi - lo == 1) {
+    SeriesTerm t = term(lo);
+    return {t.p, t.q, t.b, t.a * t.p};
+  }
+  const size_t mid = lo + (hi - lo) / 2;
+  const Split l = binary_split(lo, mid, term), r = binary_split(mid, hi, term);
+  return {l.P * r.P, l.Q * r.Q, l.B * r.B, r.B * r.Q * l.T + l.B * l.P * r.T};
+}
+
+// Enclosure of a partial sum widened by `tail` units in the last place for the truncated terms
+Enclosure to_enclosure(const Split &s, size_t digits, const BigInt &tail) {
+  const BigInt num = s.T * ten_power(digits), den = s.B * s.Q;
+  return {floor_div(num, den) - tail, ceil_div(num, den) + tail, digits};
+}
+
+// e = sum 1/k!, where the terms from N on add up to less than 2/N!
+Enclosure e_enclosure(size_t digits) {
+  size_t terms = 1;
+  for (long double log_factorial = 0; log_factorial < digits + 1; ++terms)
+    log_factorial += std::log10((long double)terms);
+  const Split s = binary_split(0, terms, [](size_t k) {
+    return SeriesTerm{1_big, 1_big, 1_big, BigInt((uintmax_t)std::max<size_t>(k, 1))};
+  });
+  return to_enclosure(s, digits, 1_big);
+}
+
+// e^(r/s) = sum (r/s)^k / k! with s > 0. Once k >= 2|r/s| the terms at least halve, so the ones from N on
+// add up to less than twice the N-th.
+Enclosure exp_enclosure(const BigInt &r, const BigInt &s, size_t digits) {
+  if (r.is_zero())
+    return {ten_power(digits), ten_power(digits), digits};
+  const long double log_x = r.log10_abs() - s.log10_abs();
+  size_t terms = (size_t)std::ceil(2 * std::pow(10.0L, log_x)) + 1;
+  while (terms * log_x - std::lgamma((long double)terms + 1) / std::log(10.0L) > -(long double)digits - 2)
+    ++terms;
+  const Split sum = binary_split(0, terms, [&](size_t k) {
+    if (k == 0)
+      return SeriesTerm{1_big, 1_big, 1_big, 1_big};
+    return SeriesTerm{1_big, 1_big, r, s * BigInt((uintmax_t)k)};
+  });
+  return to_enclosure(sum, digits, 1_big);
+}
+
+// atan(1/m) = sum (-1)^k / ((2k + 1) m^(2k+1)), alternating with decreasing terms, so the tail is
+// smaller than the first omitted term
+Enclosure atan_inverse_enclosure(uintmax_t m, size_t digits) {
+  size_t terms = 1;
+  while ((2 * terms + 1) * std::log10((long double)m) < digits + 1)
+    ++terms;
+  const BigInt m_sq((uintmax_t)(m * m));
+  const Split s = binary_split(0, terms, [&](size_t k) {
+    const BigInt b((uintmax_t)(2 * k + 1));
+    return k == 0 ? SeriesTerm{1_big, b, 1_big, BigInt(m)} : SeriesTerm{1_big, b, -1_big, m_sq};
+  });
+  return to_enclosure(s, digits, 1_big);
+}
+
+// Machin's formula pi = 16 atan(1/5) - 4 atan(1/239)
+Enclosure pi_enclosure(size_t digits) {
+  const Enclosure a = atan_inverse_enclosure(5, digits + 2), b = atan_inverse_enclosure(239, digits + 2);
+  return rescale({16_big * a.lo - 4_big * b.hi, 16_big * a.hi - 4_big * b.lo, digits + 2}, digits);
+}
+
+// ln 2 = sum 1 / ((k + 1) 2^(k+1)), where the terms from N on add up to less than 2^-N
+Enclosure ln2_enclosure(size_t digits) {
+  const size_t terms = (size_t)std::ceil((digits + 1) / std::log10(2.0L));
+  const Split s = binary_split(0, terms, [](size_t k) {
+    return SeriesTerm{1_big, BigInt((uintmax_t)(k + 1)), 1_big, 2_big};
+  });
+  return to_enclosure(s, digits, 1_big);
+}
+
+// pi^n from a more precise enclosure of pi, as the relative error grows n-fold
+Enclosure pi_power_enclosure(size_t n, size_t digits) {
+  if (n == 0)
+    return {ten_power(digits), ten_power(digits), digits};
+  const size_t inner = digits + (size_t)std::ceil(0.5L * n + std::log10((long double)n + 1)) + 3;
+  const Enclosure pi = pi_enclosure(inner);
+  const BigInt scale = ten_power(inner * n - digits);
+  return {floor_div(fast_pow(pi.lo, n), scale), ceil_div(fast_pow(pi.hi, n), scale), digits};
+}
+
+// e^(q*pi) through the monotonicity of exp: the bounds of q*pi give the bounds of e^(q*pi)
+Enclosure exp_pi_enclosure(const Fraction &q, size_t digits) {
+  const long double x = q.numerator.to_long_double() / q.denominator.to_long_double() * M_PIl;
+  const size_t inner = digits + (size_t)std::max(0.0L, std::ceil(x / std::log(10.0L))) + 2;
+  const Enclosure pi = pi_enclosure(inner);
+  const bool negative = q.is_negative();
+  const BigInt lo = floor_div(q.numerator * (negative ? pi.hi : pi.lo), q.denominator);
+  const BigInt hi = ceil_div(q.numerator * (negative ? pi.lo : pi.hi), q.denominator);
+  const BigInt unit = ten_power(inner);
+  return {exp_enclosure(lo, unit, digits).lo, exp_enclosure(hi, unit, digits).hi, digits};
+}
+
+// Sign of a + b*alpha, and -log10 of its size relative to b*alpha
+struct Gap {
+  int sign;           // 0 if it is still undecided at the maximal precision
+  long double digits; // 0 when b = 0
+};
+
+// Certifies the sign of a + b*alpha for alpha > 0, doubling the precision of alpha until its enclosure
+// leaves no doubt. Only a + b*alpha = 0 stays undecided, which for irrational alpha needs a = b = 0.
+Gap certify_sign(const Fraction &a, const Fraction &b, const Constant &alpha, size_t max_digits = 1024) {
+  if (b.is_zero())
+    return {sign_of(a.numerator), 0};
+  // (a + b*alpha) * den(a) * den(b) * 10^digits lies between ka * 10^digits + kb * [lo, hi]
+  const BigInt ka = a.numerator * b.denominator, kb = b.numerator * a.denominator;
+  for (size_t digits = 32;; digits = std::min(2 * digits, max_digits)) {
+    const Enclosure x = alpha(digits);
+    const BigInt base = ka * ten_power(x.digits), scaled = kb * x.lo;
+    BigInt lo = base + scaled, hi = base + kb * x.hi;
+    if (kb.is_negative())
+      std::swap(lo, hi);
+    if (sign_of(lo) > 0)
+      return {1, scaled.log10_abs() - lo.log10_abs()};
+    if (sign_of(hi) < 0)
+      return {-1, scaled.log10_abs() - hi.log10_abs()};
+    if (digits >= max_digits)
+      return {0, (long double)max_digits};
+  }
+}
+
+#endif // CONSTANTS_HPP
@@ -1,22 +1,18 @@
 #ifndef EQUATION_HPP
 #define EQUATION_HPP
 
+#include <optional>
 #include <stdexcept>
-#include <tuple>
 #include <utility>
+#include <vector>
 
-template <typename T> inline T determinant2(const T &a1, const T &a2, const T &b1, const T &b2) {
-  return a1 * b2 - a2 * b1;
+// a * b - c * d; BigInt provides a fused overload that skips the temporary for the result
+template <typename T> inline T mul_sub(const T &a, const T &b, const T &c, const T &d) {
+  return a * b - c * d;
 }
 
-template <typename T>
-inline std::pair<T, T> solve2(const T &a1, const T &a2, const T &b1, const T &b2, const T &c1, const T &c2) {
-  T D = determinant2(a1, a2, b1, b2);
-  if (!bool(D))
-    throw std::domain_error("No unique solution exists for the system of equations.");
-  T A = determinant2(c1, c2, b1, b2);
-  T B = determinant2(a1, a2, c1, c2);
-  return {-A / D, -B / D};
+template <typename T> inline T determinant2(const T &a1, const T &a2, const T &b1, const T &b2) {
+  return mul_sub(a1, b2, a2, b1);
 }
 
 template <typename T>
@@ -25,17 +21,45 @@ inline T determinant3(const T &a1, const T &a2, const T &a3, const T &b1, const
   return a1 * b2 * c3 - a1 * b3 * c2 - a2 * b1 * c3 + a2 * b3 * c1 + a3 * b1 * c2 - a3 * b2 * c1;
 }
 
-template <typename T>
-inline std::tuple<T, T, T> solve3(const T &a1, const T &a2, const T &a3, const T &b1, const T &b2,
-                                  const T &b3, const T &c1, const T &c2, const T &c3, const T &d1,
-                                  const T &d2, const T &d3) {
-  T D = determinant3(a1, a2, a3, b1, b2, b3, c1, c2, c3);
-  if (!bool(D))
-    throw std::domain_error("No unique solution exists for the system of equations.");
-  T A = determinant3(d1, d2, d3, b1, b2, b3, c1, c2, c3);
-  T B = determinant3(a1, a2, a3, d1, d2, d3, c1, c2, c3);
-  T C = determinant3(a1, a2, a3, b1, b2, b3, d1, d2, d3);
-  return {-A / D, -B / D, -C / D};
+// Solves sum_j m[i][j] * x[j] = m[i][n] for i < n, given the augmented n x (n + 1) matrix m over an integral
+// domain T, by fraction-free Gaussian elimination (Bareiss). Every division is exact, so entries stay in
+// T and never grow past the minors of m. Returns X and D with x = X / D, leaving that single division to
+// the caller, or nothing if m is singular.
+template <typename T> std::optional<std::pair<std::vector<T>, T>> try_bareiss(std::vector<std::vector<T>> m) {
+  const size_t n = m.size();
+  T previous(1);
+  for (size_t k = 0; k < n; ++k) {
+    size_t pivot = k;
+    while (pivot < n && !bool(m[pivot][k]))
+      ++pivot;
+    if (pivot == n)
+      return std::nullopt;
+    std::swap(m[k], m[pivot]);
+    for (size_t i = k + 1; i < n; ++i) {
+      for (size_t j = k + 1; j <= n; ++j)
+        m[i][j] = mul_sub(m[i][j], m[k][k], m[i][k], m[k][j]) / previous;
+      m[i][k] = T(0);
+    }
+    previous = m[k][k];
+  }
+  // Row i now reads sum_j m[i][j] x[j] = m[i][n] with m[i][j] = 0 for j < i, and the last pivot is the
+  // determinant up to sign, so X = x * D is integral and each back substitution divides exactly
+  const T &D = m[n - 1][n - 1];
+  std::vector<T> X(n);
+  for (size_t i = n; i-- > 0;) {
+    T sum = m[i][n] * D;
+    for (size_t j = i + 1; j < n; ++j)
+      sum = sum - m[i][j] * X[j];
+    X[i] = sum / m[i][i];
+  }
+  return std::make_pair(std::move(X), D);
+}
+
+// try_bareiss() for systems known to be regular
+template <typename T> std::pair<std::vector<T>, T> bareiss(std::vector<std::vector<T>> m) {
+  if (auto solution = try_bareiss(std::move(m)))
+    return std::move(*solution);
+  throw std::domain_error("No unique solution exists for the system of equations.");
 }
 
 #endif // EQUATION_HPP
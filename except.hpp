@@ -1,6 +1,7 @@
 #ifndef EXCEPT_HPP
 #define EXCEPT_HPP
 
+#include <new>
 #include <stdexcept>
 #include <string>
 
@@ -9,4 +10,16 @@ public:
   explicit not_implemented(const std::string &feature) : logic_error(feature + " not implemented") {}
 };
 
+// A solve stopped by its deadline, see CancelToken
+class timed_out : public std::runtime_error {
+public:
+  explicit timed_out(const std::string &what) : runtime_error(what) {}
+};
+
+// An allocation that would pass the memory budget, see MemoryUsage
+class memory_exhausted : public std::bad_alloc {
+public:
+  const char *what() const noexcept override { return "Memory budget exhausted"; }
+};
+
 #endif // EXCEPT_HPP
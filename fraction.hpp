@@ -22,6 +22,13 @@ struct Fraction {
   }
   explicit Fraction(const std::string &s) { from_str(s); }
 
+  // num / den already in lowest terms with den > 0, skipping the GCD
+  static Fraction reduced(const BigInt &num, const BigInt &den) {
+    Fraction f;
+    f.numerator = num, f.denominator = den;
+    return f;
+  }
+
   Fraction &set(const BigInt &num) {
     return this->numerator = num, this->denominator.set((uintmax_t)1), *this;
   }
@@ -34,6 +41,11 @@ struct Fraction {
   }
 
   void simplify() {
+    if (numerator.is_zero()) {
+      // 0 / d would otherwise keep the sign of d in a zero numerator, which compares as negative
+      numerator.set((uintmax_t)0), denominator.set((uintmax_t)1);
+      return;
+    }
     BigInt gcd = find_gcd(numerator, denominator);
     numerator /= gcd, denominator /= gcd;
     if (denominator.is_negative())
@@ -48,11 +60,11 @@ struct Fraction {
   }
 
   Fraction operator+(const Fraction &other) const {
-    return Fraction(numerator * other.denominator + other.numerator * denominator,
+    return Fraction(mul_add(numerator, other.denominator, other.numerator, denominator),
                     denominator * other.denominator);
   }
   Fraction operator-(const Fraction &other) const {
-    return Fraction(numerator * other.denominator - other.numerator * denominator,
+    return Fraction(mul_sub(numerator, other.denominator, other.numerator, denominator),
                     denominator * other.denominator);
   }
   Fraction operator*(const Fraction &other) const {
@@ -67,16 +79,16 @@ struct Fraction {
   }
   bool operator!=(const Fraction &other) const { return !(*this == other); }
   bool operator<(const Fraction &other) const {
-    return numerator * other.denominator < other.numerator * denominator;
+    return cmp_products(numerator, other.denominator, other.numerator, denominator) < 0;
   }
   bool operator<=(const Fraction &other) const {
-    return numerator * other.denominator <= other.numerator * denominator;
+    return cmp_products(numerator, other.denominator, other.numerator, denominator) <= 0;
   }
   bool operator>(const Fraction &other) const {
-    return numerator * other.denominator > other.numerator * denominator;
+    return cmp_products(numerator, other.denominator, other.numerator, denominator) > 0;
   }
   bool operator>=(const Fraction &other) const {
-    return numerator * other.denominator >= other.numerator * denominator;
+    return cmp_products(numerator, other.denominator, other.numerator, denominator) >= 0;
   }
 
   Fraction &operator+=(const Fraction &other) { return *this = *this + other; }
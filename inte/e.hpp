@@ -1,7 +1,7 @@
 #ifndef INTE_E_HPP
 #define INTE_E_HPP
 
-#include "../utils.hpp"
+#include "../moments.hpp"
 
 const std::pair<std::string, std::string> bound_e = {"0", "1"};
 
@@ -20,25 +20,74 @@ std::pair<Symbol, Symbol> get_coeffs_e(const Poly_s &func) {
   return {A, B};
 }
 
+// Integrate[x^k * exp[x], {x, 0, 1}] = A + B*e
+Moments<2> moments_e() {
+  return Moments<2>([](size_t k, const std::deque<Form<2>> &mu) {
+    if (k == 0)
+      return Form<2>{{-1, 1}};
+    const Fraction n((uintmax_t)k);
+    return Form<2>{{-n * mu[k - 1][0], 1_frac - n * mu[k - 1][1]}};
+  });
+}
+
+// A and B of x^n * (1-x)^n * (a + b*x), which do not depend on the inequality
+std::array<Symbol, 2> forms_e(size_t n) {
+  auto [A, B] = get_coeffs_e(aux_poly(n, n, Poly_s{'a'_sym, 'b'_sym}));
+  return {A, B};
+}
+
+// x^n * (1-x)^n * (a + b*x) for a single n, built without the previous ones
+std::optional<std::tuple<Fraction, Fraction>> attempt_e(const Fraction &a, const Fraction &b, size_t n,
+                                                        const SearchOptions &opt) {
+  auto [A, B] = forms_e(n);
+  A -= Symbol(a), B -= Symbol(b);
+  return certify_ab(A, B, opt);
+}
+
+// Smallest n expected to certify a relative gap of 10^-digits. The certificates behave like Pade
+// approximations of e, accurate to about (4n/e)^(-2n), which matches random inputs within one.
+size_t estimate_n_e(long double digits) {
+  size_t n = 1;
+  while (2 * n * std::log10(4 * n / M_El) < digits)
+    ++n;
+  return n;
+}
+
 // a + b*e >= 0
-std::tuple<size_t, Fraction, Fraction> solve_e(const Fraction &a, const Fraction &b, size_t limit = 64) {
+std::tuple<size_t, Fraction, Fraction> solve_e(const Fraction &a, const Fraction &b, size_t limit = 64,
+                                               const SearchOptions &opt = {}) {
+  const size_t hint = precheck(a, b, e_enclosure, estimate_n_e, opt);
+  if (opt.direct()) {
+    if (auto found = search_direct([&](size_t n) { return attempt_e(a, b, n, opt); }, limit, opt, hint))
+      return std::tuple_cat(std::make_tuple(found->first), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 'b'_sym}; // a + b*x
   for (size_t n = 0; n <= limit; ++n) {
+    note_attempt(n);
     // A + B*e
     auto [A, B] = get_coeffs_e(func);
     A -= Symbol(a), B -= Symbol(b);
-    try {
-      auto [a, b] = solve_ab(A, B);
-      if (ensure_nonegative(a, b))
-        return {n, a, b};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_ab(A, B, opt))
+      return std::tuple_cat(std::make_tuple(n), *cert);
     func = Poly_s{1_sym, -1_sym} * func, func.lshift();
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
 
+// a + b*e >= 0 with x^n * (1-x)^m * (a + b*x),
+// trying pairs (n, m) by increasing total degree
+std::tuple<size_t, size_t, Fraction, Fraction> solve_e_nm(const Fraction &a, const Fraction &b,
+                                                          size_t limit = 64, const SearchOptions &opt = {}) {
+  precheck(a, b, e_enclosure, nullptr, opt);
+  Moments<2> mu = moments_e();
+  const Form<2> target{{a, b}};
+  auto attempt = [&](size_t n, size_t m) { return attempt_window(mu, n, m, target, opt); };
+  if (auto found = cost_ordered_search(attempt, certificate_size<2>, limit))
+    return std::tuple_cat(std::make_tuple(std::get<0>(*found), std::get<1>(*found)), std::get<2>(*found));
+  throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+}
+
 // x**n * (1-x)**m * (a + b*x) * exp(x)
 std::string ans_to_sympy_e(size_t n, size_t m, const Fraction &a, const Fraction &b) {
   return "x**" + std::to_string(n) + " * (1-x)**" + std::to_string(m) + " * (" + a.to_str() + " + " +
@@ -1,46 +1,95 @@
 #ifndef E_POWER_PI_HPP
 #define E_POWER_PI_HPP
 
-#include "../utils.hpp"
+#include "../moments.hpp"
 
 const std::pair<std::string, std::string> bound_e_power_pi = {"0", "pi"};
 
 // Integrate[P(sin[x]) * exp[x], {x, 0, pi}] = A + B*e^pi
 std::pair<Symbol, Symbol> get_coeffs_e_power_pi(const Poly_s &func) {
   static const BigInt one(1);
-  Symbol A, B;
-  Fraction a[2] = {-1, {1, 2}};
-  Fraction b[2] = {1, {1, 2}};
-  for (size_t i = 0; i < func.coeffs.size(); ++i) {
-    if (i >> 1) {
-      BigInt n(i);
-      Fraction k(n * (n - one), n * n + one);
-      a[i & 1] *= k, b[i & 1] *= k;
+  const Fraction a[2] = {-1, {1, 2}};
+  const Fraction b[2] = {1, {1, 2}};
+  // Integrals of sin[x]^i and sin[x]^(i-2) differ by a factor n(n-1) / (n^2 + 1)
+  auto [even, odd] = parity_sums(func.coeffs, [](size_t i) {
+    const BigInt n((uintmax_t)i);
+    return std::make_pair(n * (n - one), n * n + one);
+  });
+  return {even * a[0] + odd * a[1], even * b[0] + odd * b[1]};
+}
+// Integrate[sin[x]^k * exp[x], {x, 0, pi}] = A + B*e^pi
+Moments<2> moments_e_power_pi() {
+  return Moments<2>([](size_t k, const std::deque<Form<2>> &mu) {
+    switch (k) {
+    case 0:
+      return Form<2>{{-1, 1}};
+    case 1:
+      return Form<2>{{Fraction(1, 2), Fraction(1, 2)}};
+    default:
+      BigInt n((uintmax_t)k);
+      return mu[k - 2] * Fraction(n * (n - 1), n * n + 1);
     }
-    A += func.coeffs[i] * a[i & 1], B += func.coeffs[i] * b[i & 1];
-  }
+  });
+}
+
+// A and B of sin(x)^n * (1-sin(x))^n * (a + b*sin(x)), which do not depend on the inequality
+std::array<Symbol, 2> forms_e_power_pi(size_t n) {
+  auto [A, B] = get_coeffs_e_power_pi(aux_poly(n, n, Poly_s{'a'_sym, 'b'_sym}));
   return {A, B};
 }
+
+// sin(x)^n * (1-sin(x))^n * (a + b*sin(x)) for a single n, built without the previous ones
+std::optional<std::tuple<Fraction, Fraction>> attempt_e_power_pi(const Fraction &a, const Fraction &b,
+                                                                 size_t n, const SearchOptions &opt) {
+  auto [A, B] = forms_e_power_pi(n);
+  A -= Symbol(a), B -= Symbol(b);
+  return certify_ab(A, B, opt);
+}
+
+// Smallest n expected to certify a relative gap of 10^-digits, fitted on random inputs: a little over
+// one more per digit of the gap or of e^pi itself
+size_t estimate_n_e_power_pi(long double digits) {
+  return (size_t)std::max(1.0L, std::ceil(1.1L * (digits + M_PIl / std::log(10.0L))) + 1);
+}
+
 // a + b*e^pi >= 0
 std::tuple<size_t, Fraction, Fraction> solve_e_power_pi(const Fraction &a, const Fraction &b,
-                                                        size_t limit = 64) {
+                                                        size_t limit = 64, const SearchOptions &opt = {}) {
+  auto alpha = [](size_t digits) { return exp_pi_enclosure(1, digits); };
+  const size_t hint = precheck(a, b, alpha, estimate_n_e_power_pi, opt);
+  if (opt.direct()) {
+    auto attempt = [&](size_t n) { return attempt_e_power_pi(a, b, n, opt); };
+    if (auto found = search_direct(attempt, limit, opt, hint))
+      return std::tuple_cat(std::make_tuple(found->first), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 'b'_sym}; // a + b*x
   for (size_t n = 0; n <= limit; ++n) {
+    note_attempt(n);
     // A + B*e^pi
     auto [A, B] = get_coeffs_e_power_pi(func);
     A -= Symbol(a), B -= Symbol(b);
-    try {
-      auto [a, b] = solve_ab(A, B);
-      if (ensure_nonegative(a, b))
-        return {n, a, b};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_ab(A, B, opt))
+      return std::tuple_cat(std::make_tuple(n), *cert);
     func = Poly_s{1_sym, -1_sym} * func, func.lshift();
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
 
+// a + b*e^pi >= 0 with sin(x)^n * (1-sin(x))^m * (a + b*sin(x)),
+// trying pairs (n, m) by increasing total degree
+std::tuple<size_t, size_t, Fraction, Fraction> solve_e_power_pi_nm(const Fraction &a, const Fraction &b,
+                                                                   size_t limit = 64,
+                                                                   const SearchOptions &opt = {}) {
+  precheck(a, b, [](size_t digits) { return exp_pi_enclosure(1, digits); }, nullptr, opt);
+  Moments<2> mu = moments_e_power_pi();
+  const Form<2> target{{a, b}};
+  auto attempt = [&](size_t n, size_t m) { return attempt_window(mu, n, m, target, opt); };
+  if (auto found = cost_ordered_search(attempt, certificate_size<2>, limit))
+    return std::tuple_cat(std::make_tuple(std::get<0>(*found), std::get<1>(*found)), std::get<2>(*found));
+  throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+}
+
 // sin(x)**n * (1-sin(x))**m * (a + b*sin(x)) * exp(x)
 std::string ans_to_sympy_e_power_pi(size_t n, size_t m, const Fraction &a, const Fraction &b) {
   return "sin(x)**" + std::to_string(n) + " * (1-sin(x))**" + std::to_string(m) + " * (" + a.to_str() +
@@ -1,7 +1,7 @@
 #ifndef E_POWER_PI_Q_HPP
 #define E_POWER_PI_Q_HPP
 
-#include "../utils.hpp"
+#include "../moments.hpp"
 
 const std::pair<std::string, std::string> bound_e_power_pi_q = {"0", "pi"};
 
@@ -10,40 +10,94 @@ std::pair<Symbol, Symbol> get_coeffs_e_power_pi_q(const Poly_s &func, const Frac
   static const BigInt one(1);
   const Fraction q_inv = ~q; // Inverse of q
   const Fraction q_sq = q * q;
-  Fraction a[2] = {-q_inv, ~(q_sq + one)};
-  Fraction b[2] = {q_inv, ~(q_sq + one)};
-  Symbol A, B;
-  for (size_t i = 0; i < func.coeffs.size(); ++i) {
-    if (i >> 1) {
-      BigInt n(i), n_sq = n * n;
-      Fraction k = Fraction(n * (n - 1)) / (q_sq + n * n);
-      a[i & 1] *= k, b[i & 1] *= k;
+  const Fraction a[2] = {-q_inv, ~(q_sq + one)};
+  const Fraction b[2] = {q_inv, ~(q_sq + one)};
+  // Integrals of sin[x]^i and sin[x]^(i-2) differ by n(n-1) / (q^2 + n^2) = n(n-1) d^2 / (p^2 + n^2 d^2)
+  const BigInt d_sq = q.denominator * q.denominator, p_sq = q.numerator * q.numerator;
+  auto [even, odd] = parity_sums(func.coeffs, [&](size_t i) {
+    const BigInt n((uintmax_t)i);
+    return std::make_pair(n * (n - one) * d_sq, p_sq + n * n * d_sq);
+  });
+  return {even * a[0] + odd * a[1], even * b[0] + odd * b[1]};
+}
+
+// Integrate[sin[x]^k * exp[q * x], {x, 0, pi}] = A + B*e^(q*pi)
+Moments<2> moments_e_power_pi_q(const Fraction &q) {
+  return Moments<2>([q_inv = ~q, q_sq = q * q](size_t k, const std::deque<Form<2>> &mu) {
+    switch (k) {
+    case 0:
+      return Form<2>{{-q_inv, q_inv}};
+    case 1:
+      return Form<2>{{~(q_sq + 1), ~(q_sq + 1)}};
+    default:
+      BigInt n((uintmax_t)k);
+      return mu[k - 2] * (Fraction(n * (n - 1)) / (q_sq + n * n));
     }
-    A += func.coeffs[i] * a[i & 1], B += func.coeffs[i] * b[i & 1];
-  }
+  });
+}
+
+// A and B of sin(x)^n * (1-sin(x))^n * (a + b*sin(x)), which do not depend on the inequality
+std::array<Symbol, 2> forms_e_power_pi_q(const Fraction &q, size_t n) {
+  auto [A, B] = get_coeffs_e_power_pi_q(aux_poly(n, n, Poly_s{'a'_sym, 'b'_sym}), q);
   return {A, B};
 }
 
+// sin(x)^n * (1-sin(x))^n * (a + b*sin(x)) for a single n, built without the previous ones
+std::optional<std::tuple<Fraction, Fraction>> attempt_e_power_pi_q(const Fraction &a, const Fraction &b,
+                                                                   const Fraction &q, size_t n,
+                                                                   const SearchOptions &opt) {
+  auto [A, B] = forms_e_power_pi_q(q, n);
+  A -= Symbol(a), B -= Symbol(b);
+  return certify_ab(A, B, opt);
+}
+
+// Smallest n expected to certify a relative gap of 10^-digits, fitted on random inputs: a little over
+// one more per digit of the gap or of e^(|q|*pi) itself
+size_t estimate_n_e_power_pi_q(const Fraction &q, long double digits) {
+  const long double abs_q = std::fabs(q.numerator.to_long_double() / q.denominator.to_long_double());
+  return (size_t)std::max(1.0L, std::ceil(1.1L * (digits + abs_q * M_PIl / std::log(10.0L))) + 1);
+}
+
 // a + b*e^(q*pi) >= 0
 std::tuple<size_t, Fraction, Fraction> solve_e_power_pi_q(const Fraction &a, const Fraction &b,
-                                                          const Fraction &q, size_t limit = 64) {
+                                                          const Fraction &q, size_t limit = 64,
+                                                          const SearchOptions &opt = {}) {
+  const size_t hint = precheck(
+      a, b, [&](size_t digits) { return exp_pi_enclosure(q, digits); },
+      [&](long double digits) { return estimate_n_e_power_pi_q(q, digits); }, opt);
+  if (opt.direct()) {
+    auto attempt = [&](size_t n) { return attempt_e_power_pi_q(a, b, q, n, opt); };
+    if (auto found = search_direct(attempt, limit, opt, hint))
+      return std::tuple_cat(std::make_tuple(found->first), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 'b'_sym}; // a + b*x
   for (size_t i = 0; i <= limit; ++i) {
+    note_attempt(i);
     // A + B*e^(q*pi)
     auto [A, B] = get_coeffs_e_power_pi_q(func, q);
     A -= Symbol(a), B -= Symbol(b);
-    try {
-      auto [a, b] = solve_ab(A, B);
-      if (ensure_nonegative(a, b))
-        return {i, a, b};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_ab(A, B, opt))
+      return std::tuple_cat(std::make_tuple(i), *cert);
     func = Poly_s{1_sym, -1_sym} * func, func.lshift();
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
 
+// a + b*e^(q*pi) >= 0 with sin(x)^n * (1-sin(x))^m * (a + b*sin(x)),
+// trying pairs (n, m) by increasing total degree
+std::tuple<size_t, size_t, Fraction, Fraction> solve_e_power_pi_q_nm(const Fraction &a, const Fraction &b,
+                                                                     const Fraction &q, size_t limit = 64,
+                                                                     const SearchOptions &opt = {}) {
+  precheck(a, b, [&](size_t digits) { return exp_pi_enclosure(q, digits); }, nullptr, opt);
+  Moments<2> mu = moments_e_power_pi_q(q);
+  const Form<2> target{{a, b}};
+  auto attempt = [&](size_t n, size_t m) { return attempt_window(mu, n, m, target, opt); };
+  if (auto found = cost_ordered_search(attempt, certificate_size<2>, limit))
+    return std::tuple_cat(std::make_tuple(std::get<0>(*found), std::get<1>(*found)), std::get<2>(*found));
+  throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+}
+
 // sin(x)**n * (1 - sin(x))**m * (a + b*sin(x)) * exp(q * x)
 std::string ans_to_sympy_e_power_pi_q(size_t n, size_t m, const Fraction &a, const Fraction &b,
                                       const Fraction &q) {
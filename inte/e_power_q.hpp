@@ -1,7 +1,7 @@
 #ifndef INTE_E_POWER_Q_HPP
 #define INTE_E_POWER_Q_HPP
 
-#include "../utils.hpp"
+#include "../moments.hpp"
 
 const std::pair<std::string, std::string> bound_e_power_q = {"0", "1"};
 
@@ -20,26 +20,82 @@ std::pair<Symbol, Symbol> get_coeffs_e_power_q(const Poly_s &func, const Fractio
   return {A, B};
 }
 
+// Integrate[x^k * exp[q * x], {x, 0, 1}] = A + B*e^q
+Moments<2> moments_e_power_q(const Fraction &q) {
+  return Moments<2>([q_inv = ~q](size_t k, const std::deque<Form<2>> &mu) {
+    if (k == 0)
+      return Form<2>{{-q_inv, q_inv}};
+    const Fraction n = Fraction((uintmax_t)k) * q_inv;
+    return Form<2>{{-n * mu[k - 1][0], q_inv - n * mu[k - 1][1]}};
+  });
+}
+
+// A and B of x^n * (1-x)^n * (a + b*x), which do not depend on the inequality
+std::array<Symbol, 2> forms_e_power_q(const Fraction &q, size_t n) {
+  auto [A, B] = get_coeffs_e_power_q(aux_poly(n, n, Poly_s{'a'_sym, 'b'_sym}), q);
+  return {A, B};
+}
+
+// x^n * (1-x)^n * (a + b*x) for a single n, built without the previous ones
+std::optional<std::tuple<Fraction, Fraction>> attempt_e_power_q(const Fraction &a, const Fraction &b,
+                                                                const Fraction &q, size_t n,
+                                                                const SearchOptions &opt) {
+  auto [A, B] = forms_e_power_q(q, n);
+  A -= Symbol(a), B -= Symbol(b);
+  return certify_ab(A, B, opt);
+}
+
+// Smallest n expected to certify a relative gap of 10^-digits, from the accuracy (4n/(e|q|))^(-2n) of the
+// Pade approximations of e^q the certificates behave like
+size_t estimate_n_e_power_q(const Fraction &q, long double digits) {
+  const long double abs_q = std::fabs(q.numerator.to_long_double() / q.denominator.to_long_double());
+  size_t n = 1;
+  while (2 * n * std::log10(4 * n / (M_El * abs_q)) < digits)
+    ++n;
+  return n;
+}
+
 // a + b*e^q >= 0
 std::tuple<size_t, Fraction, Fraction> solve_e_power_q(const Fraction &a, const Fraction &b,
-                                                       const Fraction &q, size_t limit = 64) {
+                                                       const Fraction &q, size_t limit = 64,
+                                                       const SearchOptions &opt = {}) {
+  const size_t hint = precheck(
+      a, b, [&](size_t digits) { return exp_enclosure(q.numerator, q.denominator, digits); },
+      [&](long double digits) { return estimate_n_e_power_q(q, digits); }, opt);
+  if (opt.direct()) {
+    auto attempt = [&](size_t n) { return attempt_e_power_q(a, b, q, n, opt); };
+    if (auto found = search_direct(attempt, limit, opt, hint))
+      return std::tuple_cat(std::make_tuple(found->first), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 'b'_sym}; // a + b*x
   for (size_t i = 0; i <= limit; ++i) {
+    note_attempt(i);
     // A + B*e^q
     auto [A, B] = get_coeffs_e_power_q(func, q);
     A -= Symbol(a), B -= Symbol(b);
-    try {
-      auto [a, b] = solve_ab(A, B);
-      if (ensure_nonegative(a, b))
-        return {i, a, b};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_ab(A, B, opt))
+      return std::tuple_cat(std::make_tuple(i), *cert);
     func = Poly_s{1_sym, -1_sym} * func, func.lshift();
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
 
+// a + b*e^q >= 0 with x^n * (1-x)^m * (a + b*x),
+// trying pairs (n, m) by increasing total degree
+std::tuple<size_t, size_t, Fraction, Fraction> solve_e_power_q_nm(const Fraction &a, const Fraction &b,
+                                                                  const Fraction &q, size_t limit = 64,
+                                                                  const SearchOptions &opt = {}) {
+  precheck(a, b, [&](size_t digits) { return exp_enclosure(q.numerator, q.denominator, digits); }, nullptr,
+           opt);
+  Moments<2> mu = moments_e_power_q(q);
+  const Form<2> target{{a, b}};
+  auto attempt = [&](size_t n, size_t m) { return attempt_window(mu, n, m, target, opt); };
+  if (auto found = cost_ordered_search(attempt, certificate_size<2>, limit))
+    return std::tuple_cat(std::make_tuple(std::get<0>(*found), std::get<1>(*found)), std::get<2>(*found));
+  throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+}
+
 // x**n * (1-x)**m * (a + b*x) * exp(q * x)
 std::string ans_to_sympy_e_power_q(size_t n, size_t m, const Fraction &a, const Fraction &b, const Fraction &q) {
   return "x**" + std::to_string(n) + " * (1-x)**" + std::to_string(m) + " * (" + a.to_str() + " + " +
@@ -1,7 +1,7 @@
 #ifndef INTE_PI_HPP
 #define INTE_PI_HPP
 
-#include "../utils.hpp"
+#include "../moments.hpp"
 
 const std::pair<std::string, std::string> bound_pi = {"0", "1"};
 
@@ -9,10 +9,8 @@ const std::pair<std::string, std::string> bound_pi = {"0", "1"};
 std::tuple<Symbol, Symbol, Symbol> get_coeffs_pi(const Poly_s &func) {
   Poly_s deno = Poly_s({1_sym, 0_sym, 1_sym}); // 1 + x^2
   auto [q, r] = func.divmod(deno);
-  Symbol A, B, C;
-  for (size_t i = 0; i < q.coeffs.size(); ++i)
-    // Integrate[q * x^i, {x, 0, 1}]
-    A += q.coeffs[i] / Fraction(i + 1);
+  // Integrate[q * x^i, {x, 0, 1}] = q / (i+1)
+  Symbol A = symbol_sum(q.coeffs, [](size_t i) { return BigInt((uintmax_t)(i + 1)); }), B, C;
   for (size_t i = 0; i < r.coeffs.size(); ++i) {
     switch (i) {
     case 0:
@@ -30,26 +28,75 @@ std::tuple<Symbol, Symbol, Symbol> get_coeffs_pi(const Poly_s &func) {
   return {A, B, C};
 }
 
+// Integrate[x^k / (1 + x^2), {x, 0, 1}] = A + B*ln(2) + C*pi
+Moments<3> moments_pi() {
+  return Moments<3>([](size_t k, const std::deque<Form<3>> &mu) {
+    switch (k) {
+    case 0:
+      return Form<3>{{0, 0, Fraction(1, 4)}};
+    case 1:
+      return Form<3>{{0, Fraction(1, 2), 0}};
+    default:
+      // x^k / (1 + x^2) = x^(k-2) - x^(k-2) / (1 + x^2)
+      return Form<3>{{Fraction(1_big, BigInt((uintmax_t)(k - 1))), 0, 0}} - mu[k - 2];
+    }
+  });
+}
+
+// A, B and C of x^n * (1-x)^n * (a + b*x + c*x^2), which do not depend on the inequality
+std::array<Symbol, 3> forms_pi(size_t n) {
+  auto [A, B, C] = get_coeffs_pi(aux_poly(n, n, Poly_s{'a'_sym, 'b'_sym, 'c'_sym}));
+  return {A, B, C};
+}
+
+// x^n * (1-x)^n * (a + b*x + c*x^2) for a single n, built without the previous ones
+std::optional<std::tuple<Fraction, Fraction, Fraction>> attempt_pi(const Fraction &a, const Fraction &b,
+                                                                   size_t n, const SearchOptions &opt) {
+  auto [A, B, C] = forms_pi(n);
+  A -= Symbol(a), C -= Symbol(b);
+  return certify_abc(A, B, C, opt);
+}
+
+// Smallest n expected to certify a relative gap of 10^-digits, fitted on random inputs: the degree grows
+// linearly, by about 5 for every 4 digits
+size_t estimate_n_pi(long double digits) { return (size_t)std::max(1.0L, std::ceil(1.25L * digits)); }
+
 // a + b*pi >= 0
 std::tuple<size_t, Fraction, Fraction, Fraction> solve_pi(const Fraction &a, const Fraction &b,
-                                                          size_t limit = 64) {
+                                                          size_t limit = 64, const SearchOptions &opt = {}) {
+  const size_t hint = precheck(a, b, pi_enclosure, estimate_n_pi, opt);
+  if (opt.direct()) {
+    if (auto found = search_direct([&](size_t n) { return attempt_pi(a, b, n, opt); }, limit, opt, hint))
+      return std::tuple_cat(std::make_tuple(found->first), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 'b'_sym, 'c'_sym}; // a + b*x + c*x^2
   for (size_t n = 0; n <= limit; ++n) {
+    note_attempt(n);
     // A + B*ln(2) + C*pi
     auto [A, B, C] = get_coeffs_pi(func);
     A -= Symbol(a), C -= Symbol(b);
-    try {
-      auto [a, b, c] = solve_abc(A, B, C);
-      if (ensure_nonegative(a, b, c))
-        return {n, a, b, c};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_abc(A, B, C, opt))
+      return std::tuple_cat(std::make_tuple(n), *cert);
     func = Poly_s{1_sym, -1_sym} * func, func.lshift();
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
 
+// a + b*pi >= 0 with x^n * (1-x)^m * (a + b*x + c*x^2),
+// trying pairs (n, m) by increasing total degree
+std::tuple<size_t, size_t, Fraction, Fraction, Fraction> solve_pi_nm(const Fraction &a, const Fraction &b,
+                                                                     size_t limit = 64,
+                                                                     const SearchOptions &opt = {}) {
+  precheck(a, b, pi_enclosure, nullptr, opt);
+  Moments<3> mu = moments_pi();
+  const Form<3> target{{a, 0, b}};
+  auto attempt = [&](size_t n, size_t m) { return attempt_window(mu, n, m, target, opt); };
+  if (auto found = cost_ordered_search(attempt, certificate_size<3>, limit))
+    return std::tuple_cat(std::make_tuple(std::get<0>(*found), std::get<1>(*found)), std::get<2>(*found));
+  throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+}
+
 // x**n * (1-x)**m * (a + b*x + c*x^2) / (1 + x^2)
 std::string ans_to_sympy_pi(size_t n, size_t m, const Fraction &a, const Fraction &b, const Fraction &c) {
   return "x**" + std::to_string(n) + " * (1-x)**" + std::to_string(m) + " * (" + a.to_str() + " + " +
@@ -15,10 +15,8 @@ std::pair<Symbol, Symbol> get_coeffs_pi_power_n(const Poly_s &func, size_t n) {
         "n must be greater than 1 for this function, please use `pi` instead of `pi_power_n`.");
   Poly_s deno = Poly_s({1_sym, 0_sym, 1_sym}); // 1 + x^2
   auto [q, r] = func.divmod(deno);
-  Symbol A, B;
-  for (size_t i = 0; i < q.coeffs.size(); ++i)
-    // Integrate[q * x^i * ln[1/x]^(n-1), {x, 0, 1}]
-    A += q.coeffs[i] / fast_pow(BigInt(i + 1), n);
+  // Integrate[q * x^i * ln[1/x]^(n-1), {x, 0, 1}] = q * (n-1)! / (i+1)^n
+  Symbol A = symbol_sum(q.coeffs, [n](size_t i) { return fast_pow(BigInt((uintmax_t)(i + 1)), n); }), B;
   A *= factorial(n - 1);
   for (size_t i = 0; i < r.coeffs.size(); ++i) {
     if (r.coeffs[i].is_zero())
@@ -38,23 +36,46 @@ std::pair<Symbol, Symbol> get_coeffs_pi_power_n(const Poly_s &func, size_t n) {
   return {A, B};
 }
 
+// A and B of x^m * (a + b*x^2), which do not depend on the inequality; m must have the opposite parity of n
+std::array<Symbol, 2> forms_pi_power_n(size_t n, size_t m) {
+  Poly_s func{'a'_sym, 0_sym, 'b'_sym}; // a + b*x^2
+  auto [A, B] = get_coeffs_pi_power_n(func.lshift(m), n);
+  return {A, B};
+}
+
+// x^m * (a + b*x^2) for a single m, which must have the opposite parity of n
+std::optional<std::tuple<Fraction, Fraction>> attempt_pi_power_n(const Fraction &a, const Fraction &b,
+                                                                 size_t n, size_t m,
+                                                                 const SearchOptions &opt) {
+  auto [A, B] = forms_pi_power_n(n, m);
+  A -= Symbol(a), B -= Symbol(b);
+  return certify_ab(A, B, opt);
+}
+
 // a + b * pi^n >= 0
 std::tuple<size_t, Fraction, Fraction> solve_pi_power_n(const Fraction &a, const Fraction &b, size_t n,
-                                                      size_t limit = 64) {
+                                                      size_t limit = 64, const SearchOptions &opt = {}) {
+  // No estimate of m: the smallest feasible one varies too much between inputs with similar gaps
+  precheck(a, b, [n](size_t digits) { return pi_power_enclosure(n, digits); }, nullptr, opt);
+  if (opt.direct()) {
+    // Only every other m is usable, so search over k with m = 2k + parity
+    const size_t parity = (n + 1) & 1;
+    auto attempt = [&](size_t k) { return attempt_pi_power_n(a, b, n, 2 * k + parity, opt); };
+    if (limit >= parity)
+      if (auto found = search_direct(attempt, (limit - parity) / 2, opt))
+        return std::tuple_cat(std::make_tuple(2 * found->first + parity), found->second);
+    throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+  }
   Poly_s func{'a'_sym, 0_sym, 'b'_sym}; // a + b*x^2
   for (size_t m = 0; m <= limit; ++m, func.lshift()) {
     if (((m + n) & 1) == 0)
       continue; // Skip even m if n is odd, and vice versa
+    note_attempt(m);
     // A + B * pi^n
     auto [A, B] = get_coeffs_pi_power_n(func, n);
     A -= Symbol(a), B -= Symbol(b);
-    try {
-      auto [a, b] = solve_ab(A, B);
-      if (ensure_nonegative(a, b))
-        return {m, a, b};
-    } catch (const std::domain_error &e) {
-      // Ignore errors, continue searching
-    }
+    if (auto cert = certify_ab(A, B, opt))
+      return std::tuple_cat(std::make_tuple(m), *cert);
   }
   throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
 }
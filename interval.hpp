@@ -0,0 +1,57 @@
+#ifndef INTERVAL_HPP
+#define INTERVAL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+#include "fraction.hpp"
+
+// Closed interval of long doubles. Each operation rounds its bounds one ulp outwards, so applying the
+// same operations to exact values inside the operands lands inside the result. Nothing here produces
+// infinities or NaNs (which -ffast-math would not handle): inputs are bounded by to_interval() and
+// division by an interval containing zero is left to the caller.
+struct Interval {
+  long double lo, hi;
+
+  Interval() : lo(0), hi(0) {}
+  Interval(long double value) : lo(value), hi(value) {}
+  Interval(long double lo, long double hi) : lo(lo), hi(hi) {}
+
+  static Interval outward(long double lo, long double hi) {
+    constexpr long double max = std::numeric_limits<long double>::max();
+    return Interval(std::nextafter(lo, -max), std::nextafter(hi, max));
+  }
+
+  Interval operator+(const Interval &other) const { return outward(lo + other.lo, hi + other.hi); }
+  Interval operator-(const Interval &other) const { return outward(lo - other.hi, hi - other.lo); }
+  Interval operator-() const { return Interval(-hi, -lo); }
+  Interval operator*(const Interval &other) const {
+    const long double p1 = lo * other.lo, p2 = lo * other.hi, p3 = hi * other.lo, p4 = hi * other.hi;
+    return outward(std::min({p1, p2, p3, p4}), std::max({p1, p2, p3, p4}));
+  }
+  // Requires !other.contains_zero()
+  Interval operator/(const Interval &other) const {
+    return *this * outward(1 / other.hi, 1 / other.lo);
+  }
+
+  bool contains_zero() const { return lo <= 0 && hi >= 0; }
+  bool is_negative() const { return hi < 0; }
+  bool is_positive() const { return lo > 0; }
+};
+
+// Interval containing f, or nothing if its parts have so many digits that squares of 3x3 determinants
+// of such intervals could leave the range of long double (about 10^4932)
+std::optional<Interval> to_interval(const Fraction &f) {
+  constexpr size_t max_digits = 600;
+  constexpr long double slack = 0x1p-58L; // Covers the error of BigInt::to_long_double()
+  if (f.numerator.digits() > max_digits || f.denominator.digits() > max_digits)
+    return std::nullopt;
+  const long double n = f.numerator.to_long_double(), d = f.denominator.to_long_double();
+  const Interval num(n - std::fabs(n) * slack, n + std::fabs(n) * slack);
+  const Interval den(d - d * slack, d + d * slack); // The denominator is positive
+  return num / den;
+}
+
+#endif // INTERVAL_HPP
@@ -1,13 +1,24 @@
 #ifndef MATHS_HPP
 #define MATHS_HPP
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "bigint.hpp"
 #include "except.hpp"
 #include "fraction.hpp"
+#include "memory.hpp"
+
+int sign_of(const BigInt &a) { return a.is_zero() ? 0 : a.get_sign(); }
 
 BigInt fast_pow(BigInt base, uint64_t exp) {
   BigInt result(1);
@@ -17,11 +28,142 @@ BigInt fast_pow(BigInt base, uint64_t exp) {
   return result;
 }
 
+// Values x(0), x(1), ... of a sequence, computed in order on first use and kept for every later caller.
+// They live in chunks of doubling size that never move, so references to them stay valid. Reading a
+// computed value takes one atomic load; extending the sequence is locked, so each value is computed once
+// however many threads ask for it.
+template <typename T> class CachedSequence {
+public:
+  CachedSequence(std::initializer_list<T> first) {
+    for (const T &x : first)
+      slot(count.load(std::memory_order_relaxed)) = x, count.fetch_add(1, std::memory_order_release);
+  }
+  // Starts with x(k) = value(k) for k < known
+  template <typename Value> CachedSequence(size_t known, const Value &value) {
+    for (size_t k = 0; k < known; ++k)
+      slot(k) = value(k), count.store(k + 1, std::memory_order_release);
+  }
+  CachedSequence(const CachedSequence &) = delete;
+  CachedSequence &operator=(const CachedSequence &) = delete;
+  ~CachedSequence() {
+    for (auto &chunk : chunks)
+      delete[] chunk.load(std::memory_order_relaxed);
+  }
+
+  // x(i) for i below a value returned by get(), or one of the first values
+  const T &operator[](size_t i) const { return at(i); }
+
+  // x(n), computing the missing values x(k) with next(k), which may read x(0), ..., x(k - 1)
+  template <typename Next> const T &get(size_t n, const Next &next) {
+    if (n < count.load(std::memory_order_acquire))
+      return at(n);
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t k = count.load(std::memory_order_relaxed); k <= n; ++k) {
+      T value = next(k);
+      slot(k) = std::move(value);
+      count.store(k + 1, std::memory_order_release);
+    }
+    return at(n);
+  }
+
+private:
+  static constexpr size_t first_chunk = 16; // Chunk c holds first_chunk * 2^c values
+
+  std::array<std::atomic<T *>, 48> chunks{};
+  std::atomic<size_t> count{0};
+  std::mutex lock;
+
+  static std::pair<size_t, size_t> locate(size_t i) {
+    const size_t c = 63 - __builtin_clzll(i / first_chunk + 1);
+    return {c, i - first_chunk * ((size_t(1) << c) - 1)};
+  }
+
+  const T &at(size_t i) const {
+    const auto [c, offset] = locate(i);
+    return chunks[c].load(std::memory_order_acquire)[offset];
+  }
+
+  // Writable x(i), allocating its chunk; only called with the lock held, or while constructing
+  T &slot(size_t i) {
+    const auto [c, offset] = locate(i);
+    T *chunk = chunks[c].load(std::memory_order_relaxed);
+    if (!chunk)
+      chunks[c].store(chunk = new T[first_chunk << c], std::memory_order_release);
+    return chunk[offset];
+  }
+};
+
+// A value below 2^128 in the base-10^4 limbs of BigInt, least significant first, made at compile time
+struct SmallValue {
+  uint32_t size = 0;
+  uint32_t limbs[10] = {}; // 10^40 > 2^128
+};
+
+constexpr SmallValue small_value(unsigned __int128 x) {
+  SmallValue value;
+  do
+    value.limbs[value.size++] = uint32_t(x % 10000), x /= 10000;
+  while (x);
+  return value;
+}
+
+BigInt from_small(const SmallValue &value) {
+  BigInt r;
+  return r.set_limbs(1, value.limbs, value.size), r;
+}
+
+// The first values of the caches below, computed by the compiler and baked into the binary. Every entry
+// of the tables must fit in 128 bits; an overflow throws, which stops the compilation.
+constexpr size_t small_two_powers = 128, small_factorials = 35, small_zigzags = 39;
+
+constexpr std::array<SmallValue, small_two_powers> two_power_table = [] {
+  std::array<SmallValue, small_two_powers> table{};
+  for (size_t n = 0; n < table.size(); ++n)
+    table[n] = small_value((unsigned __int128)1 << n);
+  return table;
+}();
+
+// n! for n < small_factorials
+constexpr std::array<SmallValue, small_factorials> factorial_table = [] {
+  std::array<SmallValue, small_factorials> table{};
+  unsigned __int128 f = 1;
+  for (size_t n = 0; n < table.size(); ++n) {
+    if (n > 1 && f > ~(unsigned __int128)0 / n)
+      throw std::overflow_error("Factorial table overflows");
+    table[n] = small_value(f *= n > 1 ? n : 1);
+  }
+  return table;
+}();
+
+// Zigzag numbers A(n) for n < small_zigzags, and the last row of the boustrophedon that makes them
+struct ZigzagTable {
+  std::array<SmallValue, small_zigzags> values, row;
+};
+
+constexpr ZigzagTable zigzag_table = [] {
+  ZigzagTable table{};
+  unsigned __int128 row[small_zigzags] = {1}, next[small_zigzags] = {};
+  table.values[0] = small_value(1);
+  for (size_t n = 1; n < small_zigzags; ++n) {
+    next[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+      next[i + 1] = next[i] + row[n - 1 - i];
+      if (next[i + 1] < next[i])
+        throw std::overflow_error("Zigzag table overflows");
+    }
+    for (size_t i = 0; i <= n; ++i)
+      row[i] = next[i];
+    table.values[n] = small_value(row[n]);
+  }
+  for (size_t i = 0; i < small_zigzags; ++i)
+    table.row[i] = small_value(row[i]);
+  return table;
+}();
+
 const BigInt &two_power(uint64_t n) {
-  static std::vector<BigInt> cache{1_big};
-  while (cache.size() <= n)
-    cache.emplace_back(cache.back() * 2_big);
-  return cache[n];
+  static CachedSequence<BigInt> cache(small_two_powers,
+                                      [](size_t k) { return from_small(two_power_table[k]); });
+  return cache.get(n, [](size_t k) { return cache[k - 1] * 2_big; });
 }
 
 const BigInt &minus_one_power(uint64_t n) {
@@ -29,79 +171,219 @@ const BigInt &minus_one_power(uint64_t n) {
   return (n & 1) ? minus_one : one;
 }
 
-const BigInt &gamma(int64_t n) {
+// Product of the integers in (lo, hi]. Splitting the range in halves keeps both operands of every
+// multiplication about the same size, where Karatsuba pays off; the leaves pack factors into machine words.
+BigInt range_product(uint64_t lo, uint64_t hi) {
+  if (hi <= lo)
+    return 1_big;
+  if (hi - lo > 32) {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    return range_product(lo, mid) * range_product(mid, hi);
+  }
+  BigInt result(1);
+  uintmax_t word = 1;
+  for (uint64_t k = lo + 1; k <= hi; ++k) {
+    if (word > UINTMAX_MAX / k)
+      result *= BigInt(word), word = 1;
+    word *= k;
+  }
+  return result * BigInt(word);
+}
+
+// a! / b! for a >= b, without computing either factorial
+BigInt factorial_ratio(uint64_t a, uint64_t b) {
+  if (a < b)
+    throw std::domain_error("Factorial ratio a! / b! requires a >= b.");
+  return range_product(b, a);
+}
+
+// Factorials are only kept at multiples of this; the others are the nearest one below times a short product
+constexpr uint64_t factorial_stride = 64;
+
+// Gamma function for positive integers, (n-1)!. Small factorials come from the table; a missing checkpoint
+// is built from the closest one below it. Concurrent searches share the checkpoints, so they are only
+// read and written under the lock, and memory pressure may drop all of them but the first at any time.
+BigInt gamma(int64_t n) {
   if (n <= 0)
     throw std::domain_error("Gamma function is not defined for non-positive integers.");
-  static std::vector<BigInt> cache{1_big, 1_big};
-  if ((uint64_t)n <= cache.size())
-    return cache[n - 1];
-  while (cache.size() < (uint64_t)n)
-    cache.emplace_back(cache.back() * BigInt((uintmax_t)cache.size()));
-  return cache[n - 1];
+  static std::map<uint64_t, BigInt> checkpoints{{0, 1_big}};
+  static std::mutex lock;
+  static const size_t trimmer = add_trimmer([] {
+    std::lock_guard<std::mutex> guard(lock);
+    checkpoints.erase(std::next(checkpoints.begin()), checkpoints.end());
+  });
+  (void)trimmer;
+  const uint64_t m = n - 1, c = m - m % factorial_stride;
+  if (m < small_factorials)
+    return from_small(factorial_table[m]);
+  relieve_memory();
+  std::unique_lock<std::mutex> guard(lock);
+  const auto below = std::prev(checkpoints.upper_bound(c));
+  const uint64_t from = below->first;
+  BigInt base = below->second;
+  guard.unlock();
+  if (from < c) {
+    base *= factorial_ratio(c, from);
+    guard.lock();
+    checkpoints.emplace(c, base);
+    guard.unlock();
+  }
+  return base * factorial_ratio(m, c);
 }
 
-const BigInt &factorial(int64_t n) {
+BigInt factorial(int64_t n) {
   if (n < 0)
     throw std::domain_error("Factorial is not defined for negative integers.");
   return gamma(n + 1);
 }
 
-// Zeta function for even integers (the result won't contain pi^n)
+// Sum of the fractions num / den = term(i) over i in [lo, hi), with den > 0, as an unreduced N / D.
+// Pairing the terms as a balanced tree keeps the operands of each level about the same size, instead of
+// cross-multiplying one small term into a huge running sum and taking a GCD after every addition.
+template <typename Term> std::pair<BigInt, BigInt> split_sum(size_t lo, size_t hi, const Term &term) {
+  if (hi - lo == 1)
+    return term(lo);
+  const size_t mid = lo + (hi - lo) / 2;
+  const auto [ln, ld] = split_sum(lo, mid, term);
+  const auto [rn, rd] = split_sum(mid, hi, term);
+  return {ln * rd + rn * ld, ld * rd};
+}
+
+// Sum of term(i) for i in [0, count), reduced once at the root
+template <typename Term> Fraction rational_sum(size_t count, const Term &term) {
+  if (count == 0)
+    return Fraction();
+  const auto [num, den] = split_sum(0, count, term);
+  return Fraction(num, den);
+}
+
+// Euler zigzag numbers 1, 1, 1, 2, 5, 16, 61, 272, ...: A(2k-1) are the tangent numbers and A(2k) the
+// secant numbers. Each row of the Seidel-Entringer boustrophedon follows from the previous one with
+// additions only, so extending the table involves no division or GCD at all.
+const BigInt &zigzag(size_t n) {
+  static CachedSequence<BigInt> cache(small_zigzags,
+                                      [](size_t k) { return from_small(zigzag_table.values[k]); });
+  static std::vector<BigInt> row = [] { // Last row of the triangle, only touched while extending the cache
+    std::vector<BigInt> last;
+    for (const SmallValue &x : zigzag_table.row)
+      last.push_back(from_small(x));
+    return last;
+  }();
+  return cache.get(n, [](size_t) {
+    std::vector<BigInt> next(row.size() + 1);
+    for (size_t i = 0; i < row.size(); ++i)
+      next[i + 1] = next[i] + row[row.size() - 1 - i];
+    row = std::move(next);
+    return row.back();
+  });
+}
+
+// Modular arithmetic for moduli below 2^32, where every product fits in 64 bits
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t p) { return a * b % p; }
+
+uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t p) {
+  uint64_t result = 1 % p;
+  for (base %= p; exp; exp >>= 1, base = mul_mod(base, base, p))
+    if (exp & 1)
+      result = mul_mod(result, base, p);
+  return result;
+}
+
+// Miller-Rabin with the bases 2, 3, 5, 7 and 11, which has no strong pseudoprimes below 2^32; larger n
+// fall back to trial division
+bool is_prime(uint64_t n) {
+  if (n < 2)
+    return false;
+  if (n >> 32) {
+    for (uint64_t d = 2; d * d <= n; ++d)
+      if (n % d == 0)
+        return false;
+    return true;
+  }
+  uint64_t odd = n - 1, twos = 0;
+  for (; odd % 2 == 0; odd /= 2)
+    ++twos;
+  for (uint64_t base : {2, 3, 5, 7, 11}) {
+    if (n == base)
+      return true;
+    if (n % base == 0)
+      return false;
+    uint64_t x = pow_mod(base, odd, n);
+    if (x == 1 || x == n - 1)
+      continue;
+    for (uint64_t i = 1; i < twos && x != n - 1; ++i)
+      x = mul_mod(x, x, n);
+    if (x != n - 1)
+      return false;
+  }
+  return true;
+}
+
+// num / (factor * m!) in lowest terms, given that only primes up to `bound` can divide both and that
+// valuation(p) = v_p(factor). With v_p(m!) from Legendre's formula, p^e is divided out of num in steps of
+// the largest powers of p that fit in a limb, which leaves a single division of the denominator instead
+// of a GCD of numbers with thousands of digits.
+template <typename Valuation>
+Fraction over_factorial(BigInt num, const BigInt &factor, uint64_t m, uint64_t bound, Valuation valuation) {
+  BigInt common(1);
+  for (uint64_t p = 2; p <= bound; ++p) {
+    if (!is_prime(p))
+      continue;
+    uint64_t e = valuation(p);
+    for (uint64_t q = p; q <= m; q *= p)
+      e += m / q;
+    while (e > 0) {
+      uint64_t step = 1, power = p;
+      while (step < e && power * p < BigIntMiniNS::COMPRESS_MOD)
+        ++step, power *= p;
+      BigInt r, q = num.div(BigInt((uintmax_t)power), r);
+      if (r.is_zero())
+        num = q, common *= BigInt((uintmax_t)power), e -= step;
+      else if (step > 1)
+        e = step - 1; // Fewer than step factors of p are left
+      else
+        break;
+    }
+  }
+  return Fraction::reduced(num, factor * factorial(m) / common);
+}
+
+// Zeta function for even integers (the result won't contain pi^n), from the tangent numbers T(k) = A(2k-1):
+// zeta(2k) / pi^(2k) = |B(2k)| 2^(2k-1) / (2k)! with |B(2k)| = 2k T(k) / (4^k (4^k - 1)). By von
+// Staudt-Clausen the reduced denominator D of B(2k) is the product of the primes p with (p - 1) | 2k, so
+// k T(k) D / (4^k - 1) is an integer and the value is that over D (2k)!, where only primes up to 2k + 1
+// can divide both.
 const Fraction &zeta(int64_t n) {
   if (n <= 1)
     throw std::domain_error("Zeta function is not defined for n <= 1.");
   if (n & 1)
     throw not_implemented("Zeta function for odd n");
   n >>= 1; // n is now even
-  static std::vector<Fraction> cache{Fraction(1)};
-  if ((uint64_t)n < cache.size())
-    return cache[n];
-  for (size_t k = cache.size(); k <= (uint64_t)n; ++k) {
-    cache.emplace_back(minus_one_power(k + 1));
-    cache.back() *= Fraction((uintmax_t)k);
-    cache.back() /= factorial(2 * k + 1);
-    for (size_t i = 1; i < k; ++i) {
-      switch (i & 1) {
-      case 0:
-        cache.back() -= cache[k - i] / factorial(2 * i + 1);
-        break;
-      case 1:
-        cache.back() += cache[k - i] / factorial(2 * i + 1);
-        break;
-      default:
-        __builtin_unreachable();
-      }
-    }
-  }
-  return cache[n];
+  static CachedSequence<Fraction> cache{Fraction(1)};
+  return cache.get(n, [](uint64_t k) {
+    BigInt d(1);
+    for (uint64_t p = 2; p <= 2 * k + 1; ++p)
+      if (2 * k % (p - 1) == 0 && is_prime(p))
+        d *= BigInt((uintmax_t)p);
+    const BigInt num = BigInt((uintmax_t)k) * zigzag(2 * k - 1) * d / (two_power(2 * k) - 1_big);
+    return over_factorial(num, d, 2 * k, 2 * k + 1,
+                          [k](uint64_t p) { return uint64_t(2 * k % (p - 1) == 0); });
+  });
 }
 
-// Dirichlet beta function for odd integers (the result won't contain pi^n)
+// Dirichlet beta function for odd integers (the result won't contain pi^n), from the secant numbers
+// S(k) = A(2k) = |E(2k)|: beta(2k+1) / pi^(2k+1) = S(k) / (4^(k+1) (2k)!)
 const Fraction &beta(int64_t n) {
   if (n <= 0)
     throw std::domain_error("Beta function is not defined for non-positive integers.");
   if (!(n & 1))
     throw not_implemented("Beta function for even n");
   n >>= 1; // Beta(2n + 1)
-  static std::vector<Fraction> cache{Fraction(1, 4)};
-  if ((uint64_t)n < cache.size())
-    return cache[n];
-  for (size_t k = cache.size(); k <= (uint64_t)n; ++k) {
-    cache.emplace_back();
-    for (size_t m = 1; m <= k; ++m) {
-      switch (m & 1) {
-      case 0:
-        cache.back() -= cache[k - m] / (factorial(2 * m) * two_power(2 * m));
-        break;
-      case 1:
-        cache.back() += cache[k - m] / (factorial(2 * m) * two_power(2 * m));
-        break;
-      default:
-        __builtin_unreachable();
-      }
-    }
-  }
-  return cache[n];
+  static CachedSequence<Fraction> cache{Fraction(1, 4)};
+  return cache.get(n, [](uint64_t k) {
+    return over_factorial(zigzag(2 * k), two_power(2 * k + 2), 2 * k, 2 * k,
+                          [k](uint64_t p) { return p == 2 ? 2 * k + 2 : uint64_t(0); });
+  });
 }
 
 #endif // MATHS_HPP
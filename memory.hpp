@@ -0,0 +1,150 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "except.hpp"
+
+// Bytes held by numbers: the limbs of every BigInt and the terms of every Symbol, which make up nearly all
+// the memory a search uses. With a budget, an allocation that would pass it throws memory_exhausted.
+// Threads add their allocations to these counters only by `grain` bytes at a time, so the counters, the
+// peak and the budget check miss up to that much per other thread.
+struct MemoryUsage {
+  std::atomic<int64_t> current{0}, peak{0};
+  std::atomic<int64_t> budget{0}; // 0 for none
+  std::atomic<int64_t> grain{4 << 10};
+};
+
+MemoryUsage memory_usage;
+
+// Sets the budget, 0 for none. The grain shrinks to 1/64 of a small budget, so the bytes that threads
+// have not counted yet stay small beside it.
+void set_memory_budget(int64_t bytes) {
+  memory_usage.budget = bytes;
+  memory_usage.grain = bytes ? std::clamp<int64_t>(bytes / 64, 64, 4 << 10) : 4 << 10;
+}
+
+void raise_peak(int64_t now) {
+  for (int64_t peak = memory_usage.peak.load(std::memory_order_relaxed);
+       now > peak && !memory_usage.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed);)
+    ;
+}
+
+// Bytes this thread allocated, less those it freed, not yet in memory_usage, and the bounds at which it
+// adds them. Trivial, so that reading it costs no call; the zero bounds of a new thread make it add its
+// first allocation at once, which also sets up PendingFlush to add what is left when the thread exits.
+struct PendingMemory {
+  int64_t bytes, high, low;
+};
+
+thread_local PendingMemory pending_memory;
+
+struct PendingFlush {
+  ~PendingFlush() {
+    const int64_t delta = pending_memory.bytes;
+    raise_peak(memory_usage.current.fetch_add(delta, std::memory_order_relaxed) + delta);
+  }
+};
+
+// Adds the pending bytes of this thread, which include the `bytes` it just allocated, to memory_usage. An
+// allocation past the budget still counts towards the peak, which then shows by how much it was missed.
+// The next bounds are a grain either way, or less above if the budget leaves less room, so every
+// allocation is checked against the budget with all the pending bytes of its own thread.
+void flush_memory(int64_t bytes) {
+  thread_local PendingFlush at_exit;
+  PendingMemory &pending = pending_memory;
+  const int64_t delta = std::exchange(pending.bytes, 0);
+  const int64_t now = memory_usage.current.fetch_add(delta, std::memory_order_relaxed) + delta;
+  raise_peak(now);
+  const int64_t budget = memory_usage.budget.load(std::memory_order_relaxed);
+  const int64_t grain = memory_usage.grain.load(std::memory_order_relaxed);
+  pending.high = budget ? std::min(grain, budget - now) : grain, pending.low = -grain;
+  if (bytes > 0 && budget && now > budget) {
+    memory_usage.current.fetch_sub(bytes, std::memory_order_relaxed);
+    throw memory_exhausted();
+  }
+}
+
+// Counts `bytes` allocated, or freed if negative
+inline void count_memory(int64_t bytes) {
+  PendingMemory &pending = pending_memory;
+  pending.bytes += bytes;
+  if (pending.bytes >= pending.high || pending.bytes <= pending.low)
+    flush_memory(bytes);
+}
+
+// Highest usage seen, with the bytes of this thread not yet counted
+int64_t peak_memory() {
+  const int64_t now = memory_usage.current.load(std::memory_order_relaxed) + pending_memory.bytes;
+  return std::max(memory_usage.peak.load(std::memory_order_relaxed), now);
+}
+
+// std::allocator counting its bytes in memory_usage
+template <typename T> struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U> CountingAllocator(const CountingAllocator<U> &) {}
+
+  // A failure of the allocation itself leaves its bytes counted, but also ends the solve
+  T *allocate(size_t n) {
+    count_memory(int64_t(n * sizeof(T)));
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) {
+    count_memory(-int64_t(n * sizeof(T)));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U> bool operator==(const CountingAllocator<U> &) const { return true; }
+  template <typename U> bool operator!=(const CountingAllocator<U> &) const { return false; }
+};
+
+// Functions freeing caches whose values can be computed again, by the id add_trimmer() gave them
+struct Trimmers {
+  std::mutex lock;
+  std::map<size_t, std::function<void()>> functions;
+  size_t next = 0;
+};
+
+Trimmers &trimmers() {
+  static Trimmers all;
+  return all;
+}
+
+size_t add_trimmer(std::function<void()> trim) {
+  Trimmers &all = trimmers();
+  std::lock_guard<std::mutex> guard(all.lock);
+  all.functions.emplace(all.next, std::move(trim));
+  return all.next++;
+}
+
+void remove_trimmer(size_t id) {
+  Trimmers &all = trimmers();
+  std::lock_guard<std::mutex> guard(all.lock);
+  all.functions.erase(id);
+}
+
+// Frees the caches that can be recomputed once usage passes three quarters of the budget, so the search
+// goes on more slowly instead of stopping at the budget. Only called where no reference into those caches
+// is held: between attempts, and before looking a value up in one of them.
+void relieve_memory() {
+  const int64_t budget = memory_usage.budget.load(std::memory_order_relaxed);
+  if (!budget || memory_usage.current.load(std::memory_order_relaxed) <= budget / 4 * 3)
+    return;
+  Trimmers &all = trimmers();
+  std::lock_guard<std::mutex> guard(all.lock);
+  for (auto &[id, trim] : all.functions)
+    trim();
+}
+
+#endif // MEMORY_HPP
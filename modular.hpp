@@ -0,0 +1,163 @@
+#ifndef MODULAR_HPP
+#define MODULAR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bigint.hpp"
+#include "maths.hpp"
+
+// The first `count` primes below 2^32, largest first. They are found once and shared by all solves.
+std::vector<uint64_t> word_primes(size_t count) {
+  static std::vector<uint64_t> primes;
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+  uint64_t n = primes.empty() ? (uint64_t(1) << 32) - 1 : primes.back() - 2;
+  for (; primes.size() < count; n -= 2)
+    if (is_prime(n))
+      primes.push_back(n);
+  return std::vector<uint64_t>(primes.begin(), primes.begin() + count);
+}
+
+// Image of the system sum_j m[i][j] * x[j] = m[i][n] modulo p: the residues of X[0..n-1] and D from
+// bareiss(), that is x * det(m) and det(m) itself. Gaussian elimination over the field Z/p gives the
+// determinant as the product of the pivots; a zero determinant leaves the X residues unknown.
+std::vector<uint64_t> modular_image(const std::vector<std::vector<BigInt>> &m, uint64_t p) {
+  const size_t n = m.size();
+  std::vector<std::vector<uint64_t>> r(n, std::vector<uint64_t>(n + 1));
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j <= n; ++j)
+      r[i][j] = m[i][j].residue(p);
+  std::vector<uint64_t> image(n + 1, 0);
+  uint64_t det = 1;
+  for (size_t k = 0; k < n; ++k) {
+    size_t pivot = k;
+    while (pivot < n && r[pivot][k] == 0)
+      ++pivot;
+    if (pivot == n)
+      return image; // det = 0 mod p
+    if (pivot != k)
+      std::swap(r[k], r[pivot]), det = p - det;
+    det = mul_mod(det, r[k][k], p);
+    const uint64_t inverse = pow_mod(r[k][k], p - 2, p);
+    for (size_t j = k; j <= n; ++j)
+      r[k][j] = mul_mod(r[k][j], inverse, p);
+    for (size_t i = k + 1; i < n; ++i)
+      for (size_t j = n + 1; j-- > k;)
+        r[i][j] = (r[i][j] + p - mul_mod(r[i][k], r[k][j], p)) % p;
+  }
+  for (size_t i = n; i-- > 0;) {
+    uint64_t x = r[i][n];
+    for (size_t j = i + 1; j < n; ++j)
+      x = (x + p - mul_mod(r[i][j], r[j][n], p)) % p;
+    r[i][n] = x;
+  }
+  for (size_t i = 0; i < n; ++i)
+    image[i] = mul_mod(r[i][n], det, p);
+  image[n] = det;
+  return image;
+}
+
+// The integer in (-M/2, M/2) with the given residues modulo the primes, M being their product. Garner's
+// algorithm finds its mixed-radix digits in word arithmetic, so only the final Horner pass is in BigInt.
+BigInt chinese_remainder(const std::vector<uint64_t> &residues, const std::vector<uint64_t> &primes,
+                         const BigInt &modulus) {
+  const size_t k = primes.size();
+  std::vector<uint64_t> digits(k);
+  for (size_t i = 0; i < k; ++i) {
+    // Digits so far evaluated modulo primes[i], then the next digit making the residue match
+    uint64_t value = 0, radix = 1;
+    for (size_t j = 0; j < i; ++j) {
+      value = (value + mul_mod(digits[j] % primes[i], radix, primes[i])) % primes[i];
+      radix = mul_mod(radix, primes[j] % primes[i], primes[i]);
+    }
+    const uint64_t delta = (residues[i] + primes[i] - value) % primes[i];
+    digits[i] = mul_mod(delta, pow_mod(radix, primes[i] - 2, primes[i]), primes[i]);
+  }
+  BigInt result;
+  for (size_t i = k; i-- > 0;)
+    result = result * BigInt((uintmax_t)primes[i]) + BigInt((uintmax_t)digits[i]);
+  if (result + result > modulus)
+    result -= modulus;
+  return result;
+}
+
+// X and D with x = X / D, as bareiss() returns them, rebuilt from images of the system modulo word-size
+// primes. By Hadamard's inequality D and every X[i] (a determinant with one column replaced by the
+// right-hand side) are at most the product of the row norms of the augmented matrix, which fixes how many
+// primes the Chinese remainder theorem needs. Primes dividing det(m) give no X residues and are replaced;
+// once they alone exceed the bound, det(m) = 0 and there is no solution. The images are independent, so
+// `threads` workers share them.
+std::optional<std::pair<std::vector<BigInt>, BigInt>>
+try_modular_solve(const std::vector<std::vector<BigInt>> &m, size_t threads = 1) {
+  const size_t n = m.size();
+  long double bound_bits = 2; // Sign and rounding of the estimate
+  for (const auto &row : m) {
+    long double top = 0;
+    for (const BigInt &x : row)
+      if (!x.is_zero())
+        top = std::max(top, x.log10_abs());
+    bound_bits += (top + 1) * std::log2(10.0L) + std::log2((long double)n + 1) / 2;
+  }
+  const long double prime_bits = 31; // Every prime used is above 2^31
+  std::vector<uint64_t> lucky, primes;
+  std::vector<std::vector<uint64_t>> images;
+  size_t tried = 0, unlucky = 0;
+  while (lucky.size() * prime_bits < bound_bits) {
+    if (unlucky * prime_bits >= bound_bits)
+      return std::nullopt;
+    const size_t wanted = (size_t)std::ceil(bound_bits / prime_bits) - lucky.size();
+    primes = word_primes(tried + wanted);
+    std::vector<std::vector<uint64_t>> batch(wanted);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+      for (size_t i; (i = next++) < wanted;)
+        batch[i] = modular_image(m, primes[tried + i]);
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min(threads, wanted); ++i)
+      pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+      thread.join();
+    for (size_t i = 0; i < wanted; ++i) {
+      if (batch[i][n] == 0)
+        ++unlucky;
+      else
+        lucky.push_back(primes[tried + i]), images.push_back(std::move(batch[i]));
+    }
+    tried += wanted;
+  }
+  BigInt modulus(1);
+  for (uint64_t p : lucky)
+    modulus *= BigInt((uintmax_t)p);
+  std::vector<uint64_t> residues(lucky.size());
+  auto rebuild = [&](size_t column) {
+    for (size_t i = 0; i < lucky.size(); ++i)
+      residues[i] = images[i][column];
+    return chinese_remainder(residues, lucky, modulus);
+  };
+  std::vector<BigInt> X(n);
+  for (size_t i = 0; i < n; ++i)
+    X[i] = rebuild(i);
+  return std::make_pair(std::move(X), rebuild(n));
+}
+
+// try_modular_solve() for systems known to be regular
+std::pair<std::vector<BigInt>, BigInt> modular_solve(const std::vector<std::vector<BigInt>> &m,
+                                                     size_t threads = 1) {
+  if (auto solution = try_modular_solve(m, threads))
+    return std::move(*solution);
+  throw std::domain_error("No unique solution exists for the system of equations.");
+}
+
+#endif // MODULAR_HPP
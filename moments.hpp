@@ -0,0 +1,92 @@
+#ifndef MOMENTS_HPP
+#define MOMENTS_HPP
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "utils.hpp"
+
+// Linear form c[0] + c[1]*alpha (+ c[2]*beta) over the constants an integral evaluates to
+template <size_t K> struct Form {
+  std::array<Fraction, K> c;
+
+  const Fraction &operator[](size_t i) const { return c[i]; }
+  Fraction &operator[](size_t i) { return c[i]; }
+
+  Form operator-(const Form &other) const {
+    Form result;
+    for (size_t i = 0; i < K; ++i)
+      result.c[i] = c[i] - other.c[i];
+    return result;
+  }
+  Form operator*(const Fraction &k) const {
+    Form result;
+    for (size_t i = 0; i < K; ++i)
+      result.c[i] = c[i] * k;
+    return result;
+  }
+};
+
+// Moments L(x^k) of an integral functional L, and the partial moments L(x^s * (1-x)^m) built from them
+template <size_t K> class Moments {
+public:
+  // Computes L(x^k) from the moments mu[0..k-1]
+  using Next = std::function<Form<K>(size_t k, const std::deque<Form<K>> &mu)>;
+
+  explicit Moments(Next next) : next(std::move(next)) {}
+
+  // L(x^k)
+  const Form<K> &moment(size_t k) {
+    while (mu.size() <= k)
+      mu.push_back(next(mu.size(), mu));
+    return mu[k];
+  }
+
+  // L(x^s * (1-x)^m), memoized through L(x^s (1-x)^m) = L(x^s (1-x)^(m-1)) - L(x^(s+1) (1-x)^(m-1))
+  const Form<K> &window(size_t s, size_t m) {
+    if (m == 0)
+      return moment(s);
+    while (partial.size() < m)
+      partial.emplace_back();
+    auto &row = partial[m - 1];
+    while (row.size() <= s) {
+      size_t t = row.size();
+      row.push_back(window(t, m - 1) - window(t + 1, m - 1));
+    }
+    return row[s];
+  }
+
+private:
+  Next next;
+  std::deque<Form<K>> mu;                  // deque keeps references stable while growing
+  std::deque<std::deque<Form<K>>> partial; // partial[m - 1][s] = L(x^s * (1-x)^m)
+};
+
+// x^n * (1-x)^m * (a + b*x [+ c*x^2]) with L(...) = target, if it is non-negative on [0, 1]
+template <size_t K>
+std::optional<std::array<Fraction, K>> attempt_window(Moments<K> &mu, size_t n, size_t m,
+                                                      const Form<K> &target, const SearchOptions &opt) {
+  std::array<Symbol, K> eq; // eq[i]: component i of L(...) - target
+  for (size_t j = 0; j < K; ++j) {
+    const Form<K> &f = mu.window(n + j, m);
+    for (size_t i = 0; i < K; ++i)
+      eq[i] += Symbol(char('a' + j), f[i]);
+  }
+  for (size_t i = 0; i < K; ++i)
+    eq[i] -= Symbol(target[i]);
+  return certify_forms(eq, opt);
+}
+
+// Number of digits in the coefficients of a certificate, a proxy for the cost of verifying it
+template <size_t K> size_t certificate_size(const std::array<Fraction, K> &cert) {
+  size_t size = 0;
+  for (const Fraction &f : cert)
+    size += f.numerator.to_str().size() + f.denominator.to_str().size();
+  return size;
+}
+
+#endif // MOMENTS_HPP
@@ -0,0 +1,207 @@
+#ifndef POSITIVITY_HPP
+#define POSITIVITY_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "fraction.hpp"
+#include "maths.hpp"
+#include "poly.hpp"
+
+// Polynomials with integer coefficients, lowest degree first and no leading zeros; empty for zero
+using Poly_z = Poly<BigInt>;
+
+// Integer polynomial with the same sign as sum p[i] x^i everywhere: p times the lcm of its denominators
+Poly_z clear_denominators(const std::vector<Fraction> &p) {
+  BigInt lcm(1);
+  for (const Fraction &c : p)
+    lcm = lcm / Fraction::find_gcd(lcm, c.denominator) * c.denominator;
+  Poly_z z;
+  for (const Fraction &c : p)
+    z.coeffs.push_back(c.numerator * (lcm / c.denominator));
+  return z.simplify(), z;
+}
+
+// p divided by the gcd of its coefficients, which is positive, so signs are kept
+Poly_z primitive(Poly_z p) {
+  BigInt g;
+  for (const BigInt &c : p.coeffs)
+    g = Fraction::find_gcd(g, c);
+  if (g.is_negative())
+    g = -g;
+  if (!g.is_zero() && !g.is_one())
+    for (BigInt &c : p.coeffs)
+      c /= g;
+  return p;
+}
+
+Poly_z derivative(const Poly_z &p) {
+  Poly_z d;
+  for (size_t i = 1; i < p.coeffs.size(); ++i)
+    d.coeffs.push_back(p.coeffs[i] * BigInt((uintmax_t)i));
+  return d;
+}
+
+// Primitive part of a remainder of a by b (b non-zero) up to a positive factor, which is what Sturm
+// sequences need: every elimination step scales a by |lc(b)|
+Poly_z pseudo_remainder(Poly_z a, const Poly_z &b) {
+  const BigInt &lead = b.coeffs.back();
+  const BigInt scale = lead.is_negative() ? -lead : lead;
+  while (a.coeffs.size() >= b.coeffs.size()) {
+    const size_t shift = a.coeffs.size() - b.coeffs.size();
+    const BigInt c = lead.is_negative() ? -a.coeffs.back() : a.coeffs.back();
+    for (BigInt &x : a.coeffs)
+      x *= scale;
+    for (size_t i = 0; i < b.coeffs.size(); ++i)
+      a.coeffs[shift + i] -= c * b.coeffs[i];
+    a.simplify();
+  }
+  return primitive(std::move(a));
+}
+
+Poly_z poly_gcd(Poly_z a, Poly_z b) {
+  a = primitive(std::move(a)), b = primitive(std::move(b));
+  while (!b.coeffs.empty()) {
+    Poly_z r = pseudo_remainder(a, b);
+    a = std::move(b), b = std::move(r);
+  }
+  return a;
+}
+
+// a / b for a primitive b dividing a over the rationals, whose quotient is then integral (Gauss's lemma)
+Poly_z exact_quotient(Poly_z a, const Poly_z &b) {
+  Poly_z q;
+  q.coeffs.resize(a.coeffs.size() >= b.coeffs.size() ? a.coeffs.size() - b.coeffs.size() + 1 : 0);
+  while (a.coeffs.size() >= b.coeffs.size()) {
+    const size_t shift = a.coeffs.size() - b.coeffs.size();
+    BigInt r, c = a.coeffs.back().div(b.coeffs.back(), r);
+    if (!r.is_zero())
+      throw std::logic_error("Polynomial division is not exact.");
+    for (size_t i = 0; i < b.coeffs.size(); ++i)
+      a.coeffs[shift + i] -= c * b.coeffs[i];
+    q.coeffs[shift] = std::move(c);
+    a.simplify();
+  }
+  if (!a.coeffs.empty())
+    throw std::logic_error("Polynomial division is not exact.");
+  return q;
+}
+
+// Sign of p(u / v) for v > 0, from the homogenized p(u, v) = v^deg(p) p(u / v)
+int sign_at(const Poly_z &p, const BigInt &u, const BigInt &v) {
+  BigInt r, power(1);
+  for (size_t i = p.coeffs.size(); i-- > 0; power *= v)
+    r = r * u + p.coeffs[i] * power;
+  return sign_of(r);
+}
+
+// Product of the square-free factors of p that occur to an odd power, by Yun's algorithm: exactly the
+// roots where p changes sign
+Poly_z odd_part(const Poly_z &p) {
+  const Poly_z dp = derivative(p), a = poly_gcd(p, dp);
+  Poly_z b = exact_quotient(p, a), c = exact_quotient(dp, a), odd{1_big};
+  for (size_t i = 1; b.coeffs.size() > 1; ++i) {
+    const Poly_z d = c - derivative(b), f = poly_gcd(b, d);
+    if (i & 1)
+      odd = odd * f;
+    b = exact_quotient(b, f), c = exact_quotient(d, f);
+  }
+  return odd;
+}
+
+// Number of distinct roots in (0, 1) of a square-free s, by Sturm's theorem
+size_t sturm_roots(Poly_z s) {
+  while (!s.coeffs.empty() && s.coeffs[0].is_zero())
+    s.coeffs.erase(s.coeffs.begin()); // Roots at 0 are not inside
+  while (s.coeffs.size() > 1 && sign_at(s, 1_big, 1_big) == 0)
+    s = exact_quotient(s, Poly_z{-1_big, 1_big}); // Nor are roots at 1
+  if (s.coeffs.size() <= 1)
+    return 0;
+  std::vector<Poly_z> chain{s, derivative(s)};
+  while (chain.back().coeffs.size() > 1) {
+    Poly_z r = pseudo_remainder(chain[chain.size() - 2], chain.back());
+    for (BigInt &c : r.coeffs)
+      c = -c;
+    if (r.coeffs.empty())
+      break;
+    chain.push_back(std::move(r));
+  }
+  auto variations = [&](const BigInt &x) {
+    size_t count = 0;
+    int last = 0;
+    for (const Poly_z &q : chain) {
+      const int sign = sign_at(q, x, 1_big);
+      if (sign != 0 && last != 0 && sign != last)
+        ++count;
+      if (sign != 0)
+        last = sign;
+    }
+    return count;
+  };
+  return variations(0_big) - variations(1_big);
+}
+
+// Bernstein coefficients of p on [0, 1] scaled by the positive d!: b[k] = sum over i <= k of
+// p[i] * k! / (k - i)! * (d - i)!
+std::vector<BigInt> bernstein(const Poly_z &p) {
+  const size_t d = p.coeffs.size() - 1;
+  std::vector<BigInt> b(d + 1);
+  for (size_t k = 0; k <= d; ++k)
+    for (size_t i = 0; i <= k; ++i)
+      b[k] += p.coeffs[i] * factorial_ratio(k, k - i) * factorial(d - i);
+  return b;
+}
+
+enum class Sign { nonnegative, negative, unknown };
+
+// Signs of a polynomial with Bernstein coefficients b on an interval: non-negative if all are, negative if
+// an endpoint value b[0] or b[d] is, otherwise decided on the two halves from de Casteljau's subdivision.
+// Each level is scaled by 2^d to stay integral.
+Sign bernstein_sign(const std::vector<BigInt> &b, size_t depth) {
+  const size_t d = b.size() - 1;
+  if (sign_of(b[0]) < 0 || sign_of(b[d]) < 0)
+    return Sign::negative;
+  bool nonnegative = true;
+  for (const BigInt &c : b)
+    nonnegative = nonnegative && sign_of(c) >= 0;
+  if (nonnegative)
+    return Sign::nonnegative;
+  if (depth == 0)
+    return Sign::unknown;
+  // Row r of the triangle holds sums of r + 1 neighbours, 2^r times their midpoint averages
+  std::vector<BigInt> row = b, left(d + 1), right(d + 1);
+  for (size_t r = 0; r <= d; ++r) {
+    left[r] = row[0] * two_power(d - r), right[d - r] = row[d - r] * two_power(d - r);
+    for (size_t i = 0; i + r < d; ++i)
+      row[i] += row[i + 1];
+  }
+  const Sign l = bernstein_sign(primitive(Poly_z(left)).coeffs, depth - 1);
+  if (l == Sign::negative)
+    return l;
+  const Sign r = bernstein_sign(primitive(Poly_z(right)).coeffs, depth - 1);
+  if (r == Sign::negative)
+    return r;
+  return l == Sign::nonnegative && r == Sign::nonnegative ? Sign::nonnegative : Sign::unknown;
+}
+
+// Whether sum p[i] x^i >= 0 on [0, 1], exactly. Bernstein coefficients with a few levels of subdivision
+// settle nearly every case; a polynomial touching zero inside the interval never gets there and is left to
+// the odd-multiplicity roots: without one in (0, 1), p keeps the sign of any point where it is non-zero.
+bool nonnegative_on_unit(const std::vector<Fraction> &p, size_t depth = 6) {
+  const Poly_z z = clear_denominators(p);
+  if (z.coeffs.size() <= 1)
+    return z.coeffs.empty() || !z.coeffs[0].is_negative();
+  const Sign sign = bernstein_sign(primitive(Poly_z(bernstein(z))).coeffs, depth);
+  if (sign != Sign::unknown)
+    return sign == Sign::nonnegative;
+  if (sturm_roots(odd_part(z)) > 0)
+    return false;
+  // Among d + 1 distinct points some is not a root
+  const size_t d = z.coeffs.size() - 1;
+  for (size_t k = 1;; ++k)
+    if (const int s = sign_at(z, BigInt((uintmax_t)k), BigInt((uintmax_t)(d + 2))))
+      return s > 0;
+}
+
+#endif // POSITIVITY_HPP
@@ -0,0 +1,245 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cancel.hpp"
+
+enum class Search {
+  linear, // n = 0, 1, 2, ..., limit, reusing the previous auxiliary polynomial
+  gallop, // n = 1, 2, 4, ... until feasible, then bisect down
+};
+
+// Counters a search adds to when SearchOptions::stats is set
+struct SearchStats {
+  std::atomic<size_t> exact{0};       // Systems solved in exact arithmetic
+  std::atomic<size_t> prefiltered{0}; // Systems the interval pass proved infeasible
+  std::atomic<size_t> singular{0};    // Exact solves without a unique solution
+  long double gap_digits = 0;          // -log10 of the relative gap |a + b*alpha| / |b*alpha|
+  size_t estimate = 0;                 // Smallest n the gap suggests, 0 without a model
+};
+
+struct SearchOptions {
+  Search mode = Search::linear;
+  size_t threads = 1;        // Workers for the linear scan, 0 for one per hardware thread
+  bool prefilter = true;     // Reject certainly infeasible systems in interval arithmetic first
+  bool precheck = true;      // Certify the sign of a + b*alpha before searching
+  SearchStats *stats = nullptr;
+
+  // Whether each n has to be evaluated on its own rather than from the previous one
+  bool direct() const { return mode != Search::linear || threads != 1; }
+};
+
+// Certificate type produced by an attempt functor, i.e. T for std::optional<T> attempt(size_t)
+template <typename Attempt>
+using certificate_t = typename std::invoke_result_t<Attempt &, size_t>::value_type;
+
+// Doubles n from `first` until attempt(n) succeeds, then bisects down to the smallest succeeding n.
+// The result is only the minimal n if feasibility is monotone in n, which holds once the auxiliary
+// polynomial is tight enough; the certificate returned is valid either way.
+template <typename Attempt>
+std::optional<std::pair<size_t, certificate_t<Attempt>>> gallop_search(Attempt &&attempt, size_t limit,
+                                                                       size_t first = 1) {
+  auto tried = [&](size_t n) { return note_attempt(n), attempt(n); };
+  if (auto cert = tried(0))
+    return std::make_pair(size_t(0), std::move(*cert));
+  size_t bad = 0, good = std::max<size_t>(first, 1);
+  std::optional<certificate_t<Attempt>> found;
+  for (; bad < limit; bad = good, good *= 2) {
+    good = std::min(good, limit);
+    if ((found = tried(good)))
+      break;
+  }
+  if (!found)
+    return std::nullopt;
+  while (good - bad > 1) {
+    size_t mid = bad + (good - bad) / 2;
+    if (auto cert = tried(mid))
+      good = mid, found = std::move(cert);
+    else
+      bad = mid;
+  }
+  return std::make_pair(good, std::move(*found));
+}
+
+// Evaluates n = first, first + 1, ..., limit on several threads. Workers pull the next untried n from a
+// shared counter, so the growing cost of large n balances itself, and stop pulling once a smaller n is
+// known to be feasible. Every n below the reported one has been tried, so the result matches the linear
+// scan. Workers share the deadline of the calling thread.
+template <typename Attempt>
+std::optional<std::pair<size_t, certificate_t<Attempt>>> parallel_search(Attempt &&attempt, size_t limit,
+                                                                         size_t threads, size_t first = 0) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::atomic<size_t> next{first}, best{SIZE_MAX};
+  std::optional<certificate_t<Attempt>> found;
+  std::exception_ptr error;
+  std::mutex lock;
+  CancelToken *const token = current_cancel;
+
+  auto worker = [&]() {
+    CancelScope scope(token);
+    try {
+      for (size_t n; (n = next++) <= limit && n < best;) {
+        note_attempt(n);
+        auto cert = attempt(n);
+        if (!cert)
+          continue;
+        std::lock_guard<std::mutex> guard(lock);
+        if (n < best)
+          best = n, found = std::move(cert);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(lock);
+      if (!error)
+        error = std::current_exception();
+      next = SIZE_MAX / 2; // Stop handing out work
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &thread : pool)
+    thread.join();
+
+  if (error)
+    std::rethrow_exception(error);
+  if (!found)
+    return std::nullopt;
+  return std::make_pair(best.load(), std::move(*found));
+}
+
+// Certificate type produced by an attempt functor over pairs, std::optional<T> attempt(size_t n, size_t m)
+template <typename Attempt>
+using pair_certificate_t = typename std::invoke_result_t<Attempt &, size_t, size_t>::value_type;
+
+// Tries the pairs (n, m) with n, m <= limit by increasing total degree n + m, the most balanced first.
+// The first degree with a certificate bounds the search: its remaining pairs are still tried and the
+// certificate with the smallest size(cert) is kept, while all pairs of higher degree are pruned.
+template <typename Attempt, typename Size>
+std::optional<std::tuple<size_t, size_t, pair_certificate_t<Attempt>>>
+cost_ordered_search(Attempt &&attempt, Size &&size, size_t limit) {
+  std::optional<std::tuple<size_t, size_t, pair_certificate_t<Attempt>>> best;
+  size_t best_size = 0;
+  auto consider = [&](size_t n, size_t m) {
+    if (n > limit || m > limit)
+      return;
+    note_attempt(n, m);
+    auto cert = attempt(n, m);
+    if (!cert)
+      return;
+    size_t cert_size = size(*cert);
+    if (!best || cert_size < best_size)
+      best.emplace(n, m, std::move(*cert)), best_size = cert_size;
+  };
+  for (size_t degree = 0; degree <= 2 * limit && !best; ++degree) {
+    for (size_t n = degree / 2 + 1; n-- > 0;) {
+      consider(n, degree - n);
+      if (n != degree - n)
+        consider(degree - n, n);
+    }
+  }
+  return best;
+}
+
+// Runs the strategies that evaluate each n independently of the previous one. The galloping search
+// starts from `hint`, an estimate of the smallest feasible n; the linear scan has to start from 0.
+template <typename Attempt>
+std::optional<std::pair<size_t, certificate_t<Attempt>>> search_direct(Attempt &&attempt, size_t limit,
+                                                                       const SearchOptions &opt,
+                                                                       size_t hint = 1) {
+  switch (opt.mode) {
+  case Search::gallop:
+    return gallop_search(attempt, limit, hint);
+  case Search::linear:
+    return parallel_search(attempt, limit, opt.threads);
+  default:
+    throw std::logic_error("Search mode is not a direct strategy.");
+  }
+}
+
+// Every feasible n up to `limit` in increasing order, found lazily: each next() resumes the scan after the
+// previous certificate and stops at the following one, so the first certificate is that of
+// parallel_search(). With one thread nothing past the last one taken is tried; with more, other workers
+// may be on up to `threads` - 1 larger n when it is found, and next() waits for those attempts to finish
+// before throwing their results away.
+template <typename Attempt> class LinearStream {
+public:
+  LinearStream(Attempt attempt, size_t limit, size_t threads)
+      : attempt(std::move(attempt)), limit(limit), threads(threads) {}
+
+  std::optional<std::pair<size_t, certificate_t<Attempt>>> next() {
+    if (start > limit)
+      return std::nullopt;
+    auto found = parallel_search(attempt, limit, threads, start);
+    start = found ? found->first + 1 : limit + 1;
+    return found;
+  }
+
+private:
+  Attempt attempt;
+  size_t start = 0, limit, threads;
+};
+
+// Every feasible pair (n, m) with n, m <= limit, lazily by increasing total degree and, within a degree,
+// by increasing size(cert) in the order of cost_ordered_search(), whose answer comes first. A degree is
+// tried as a whole when the previous one has been used up.
+template <typename Attempt, typename Size> class DegreeStream {
+public:
+  using Found = std::tuple<size_t, size_t, pair_certificate_t<Attempt>>;
+
+  DegreeStream(Attempt attempt, Size size, size_t limit)
+      : attempt(std::move(attempt)), size(std::move(size)), limit(limit) {}
+
+  std::optional<Found> next() {
+    for (; pending.empty() && degree <= 2 * limit; ++degree) {
+      std::vector<std::pair<size_t, Found>> found;
+      auto consider = [&](size_t n, size_t m) {
+        if (n > limit || m > limit)
+          return;
+        note_attempt(n, m);
+        if (auto cert = attempt(n, m)) {
+          const size_t cert_size = size(*cert);
+          found.emplace_back(cert_size, Found(n, m, std::move(*cert)));
+        }
+      };
+      for (size_t n = degree / 2 + 1; n-- > 0;) {
+        consider(n, degree - n);
+        if (n != degree - n)
+          consider(degree - n, n);
+      }
+      std::stable_sort(found.begin(), found.end(),
+                       [](const auto &x, const auto &y) { return x.first < y.first; });
+      for (auto &f : found)
+        pending.push_back(std::move(f.second));
+    }
+    if (pending.empty())
+      return std::nullopt;
+    Found first = std::move(pending.front());
+    pending.pop_front();
+    return first;
+  }
+
+private:
+  Attempt attempt;
+  Size size;
+  size_t limit, degree = 0;
+  std::deque<Found> pending;
+};
+
+#endif // SEARCH_HPP
@@ -0,0 +1,160 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Longest request line a server reads; a longer one ends the connection
+constexpr size_t max_request_line = 1 << 20;
+
+// Blocking line I/O over a connected socket, which it closes
+class LineSocket {
+public:
+  explicit LineSocket(int fd) : fd(fd) {}
+  LineSocket(const LineSocket &) = delete;
+  LineSocket &operator=(const LineSocket &) = delete;
+  ~LineSocket() { ::close(fd); }
+
+  // The next line without its newline, or nothing at the end of the stream. A line longer than `max`
+  // is an error.
+  std::optional<std::string> read_line(size_t max = max_request_line) {
+    for (size_t scanned = 0;;) {
+      if (size_t end = buffer.find('\n', scanned); end != std::string::npos) {
+        std::string line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        return line;
+      }
+      scanned = buffer.size();
+      if (scanned > max)
+        throw std::length_error("Request line too long");
+      char chunk[4096];
+      const ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+      if (got <= 0) {
+        if (buffer.empty())
+          return std::nullopt;
+        std::string line = std::move(buffer); // Last line without a newline
+        buffer.clear();
+        return line;
+      }
+      buffer.append(chunk, got);
+    }
+  }
+
+  // Whether the whole line and a newline were sent; a closed peer is not a signal
+  bool write_line(const std::string &line) {
+    const std::string data = line + "\n";
+    for (size_t sent = 0; sent < data.size();) {
+      const ssize_t put = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (put <= 0)
+        return false;
+      sent += put;
+    }
+    return true;
+  }
+
+private:
+  int fd;
+  std::string buffer;
+};
+
+sockaddr_un unix_address(const std::string &path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    throw std::invalid_argument("Socket path too long: " + path);
+  std::strcpy(address.sun_path, path.c_str());
+  return address;
+}
+
+int connect_unix(const std::string &path) {
+  const sockaddr_un address = unix_address(path);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    throw std::runtime_error("Cannot create a socket");
+  if (::connect(fd, (const sockaddr *)&address, sizeof(address)) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot connect to " + path);
+  }
+  return fd;
+}
+
+// Listens at `path`, replacing a stale socket left there but no other kind of file
+int listen_unix(const std::string &path, int backlog) {
+  const sockaddr_un address = unix_address(path);
+  struct stat st;
+  if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    ::unlink(path.c_str());
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    throw std::runtime_error("Cannot create a socket");
+  if (::bind(fd, (const sockaddr *)&address, sizeof(address)) != 0 || ::listen(fd, backlog) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot listen at " + path);
+  }
+  return fd;
+}
+
+// Serves the socket at `path` until the process ends. Each of `workers` threads takes one connection at a
+// time and answers its lines in order with answer(line), skipping empty answers. At most `pending`
+// accepted connections wait for a worker; while that many do, no more are accepted and new clients wait
+// in the listen backlog, so a burst slows clients down instead of growing the server without bound.
+void serve(const std::string &path, size_t workers, size_t pending,
+           const std::function<std::string(const std::string &line)> &answer) {
+  const int listener = listen_unix(path, 64);
+  std::deque<int> queue;
+  std::mutex lock;
+  std::condition_variable queued, taken;
+
+  auto worker = [&]() {
+    for (;;) {
+      std::unique_lock<std::mutex> guard(lock);
+      queued.wait(guard, [&] { return !queue.empty(); });
+      LineSocket client(queue.front());
+      queue.pop_front();
+      guard.unlock();
+      taken.notify_one();
+      try {
+        while (auto line = client.read_line())
+          if (const std::string reply = answer(*line); !reply.empty() && !client.write_line(reply))
+            break;
+      } catch (const std::length_error &e) {
+        client.write_line(std::string("error : ") + e.what());
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+    pool.emplace_back(worker);
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      taken.wait(guard, [&] { return queue.size() < std::max<size_t>(pending, 1); });
+    }
+    const int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0)
+      continue; // Interrupted, or a client that gave up
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      queue.push_back(fd);
+    }
+    queued.notify_one();
+  }
+}
+
+#endif // SERVER_HPP
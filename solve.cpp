@@ -1,10 +1,18 @@
+#include "batch.hpp"
 #include "inte/e.hpp"
 #include "inte/e_power_pi.hpp"
 #include "inte/e_power_pi_q.hpp"
 #include "inte/e_power_q.hpp"
 #include "inte/pi.hpp"
 #include "inte/pi_power_n.hpp"
+#include "server.hpp"
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <vector>
 
 // Test: solve pi -4738167652 14885392687
 //       solve e -71 193
@@ -38,59 +46,539 @@ std::string match_uint(const std::string &pattern, const std::string &input) {
   return "";
 }
 
+const char *usage = "Usage: solve [<options>] <type> <B> <A> [<limit=64>]\n"
+                    "       solve [<options>] --batch[=<file>] [<limit=64>]\n"
+                    "       solve --tables=<dir> generate <type> <limit>\n"
+                    "       solve [<options>] --serve=<socket> [<limit=64>]\n"
+                    "       solve --connect=<socket> <type> <B> <A> [<limit>]\n"
+                    "       solve --connect=<socket> --batch[=<file>]\n"
+                    "Options:\n"
+                    "  --batch[=<file>]        read `<type> <B> <A> [<limit>]` lines from the file or stdin\n"
+                    "  --tables=<dir>          read the forms of each type from the tables in <dir>\n"
+                    "  --serve=<socket>        answer batch lines sent to a Unix socket, up to <limit>\n"
+                    "  --workers=<n>           connections the server answers at once (default: all cores)\n"
+                    "  --connect=<socket>      send the queries to a server instead of solving them\n"
+                    "  --search=linear|gallop  strategy over n (default: linear)\n"
+                    "  --threads=<n>           workers for the linear search, 0 for all cores (default: 1)\n"
+                    "  --asymmetric            search x^n * (1-x)^m by total degree n + m\n"
+                    "  --all                   print every certificate up to the limit as it is found\n"
+                    "  --count=<k>             print the first <k> certificates up to the limit\n"
+                    "  --no-prefilter          solve every candidate exactly, without the interval pass\n"
+                    "  --no-precheck           search without certifying the sign of A + B*alpha first\n"
+                    "  --cache=<dir>           keep results in <dir> as well as in memory\n"
+                    "  --cache-size=<bytes>    limit of the cache directory, with K, M or G (default: 64M)\n"
+                    "  --timeout=<seconds>     give up on a query after this long, with exit code 4\n"
+                    "  --max-memory=<bytes>    limit of the numbers in memory, with K, M or G; past it a\n"
+                    "                          query fails, a single one with exit code 5\n"
+                    "  --stats                 print search, cache and memory counters to stderr";
+
+// Value of `--name=value`, or "" if input is another argument
+std::string match_option(const std::string &name, const std::string &input) {
+  if (input.length() <= name.length() + 1)
+    return "";
+  if (input.substr(0, name.length()) != name || input[name.length()] != '=')
+    return "";
+  return input.substr(name.length() + 1);
+}
+
+// Number of bytes in a size such as 4096, 512K, 64M or 2G
+uint64_t parse_size(const std::string &input) {
+  size_t end;
+  const uint64_t value = std::stoull(input, &end);
+  const std::string suffix = input.substr(end);
+  if (suffix.empty())
+    return value;
+  if (suffix == "K" || suffix == "k")
+    return value << 10;
+  if (suffix == "M" || suffix == "m")
+    return value << 20;
+  if (suffix == "G" || suffix == "g")
+    return value << 30;
+  throw std::invalid_argument("Invalid size: " + input);
+}
+
+// Results the cache of a batch or a server keeps in memory
+constexpr size_t cached_results = 1 << 16;
+
+std::string describe(const CacheStats &stats) {
+  return std::to_string(stats.hits) + " hits (" + std::to_string(stats.disk_hits) + " from disk), " +
+         std::to_string(stats.misses) + " misses";
+}
+
+// Bytes in KiB, MiB or GiB, whichever keeps the number small
+std::string format_size(int64_t bytes) {
+  const char *units[] = {"KiB", "MiB", "GiB"};
+  double value = bytes / 1024.0;
+  size_t unit = 0;
+  for (; value >= 1024 && unit + 1 < std::size(units); ++unit)
+    value /= 1024;
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.1f %s", value, units[unit]);
+  return text;
+}
+
+std::string describe_memory() {
+  const int64_t budget = memory_usage.budget;
+  return "peak " + format_size(peak_memory()) + " of numbers" +
+         (budget ? ", budget " + format_size(budget) : "");
+}
+
+// Prints the peak memory to stderr when the run ends, however it ends
+struct MemoryReport {
+  bool enabled = false;
+  ~MemoryReport() {
+    if (enabled)
+      std::cerr << "Memory   : " << describe_memory() << std::endl;
+  }
+};
+
+// Name of type `tp` with its parameter written in lowest terms, so that equal types share their forms,
+// tables and cached results
+std::string canonical_type(const std::string &tp) {
+  if (const std::string str = match_uint("pi_power_", tp); !str.empty())
+    return "pi_power_" + std::to_string(stoull(str));
+  if (const std::string str = match_sint("e_power_", tp); !str.empty())
+    return "e_power_" + Fraction(str).to_string();
+  if (const std::string str = match_sint("e_power_pi_", tp); !str.empty())
+    return "e_power_pi_" + Fraction(str).to_string();
+  return tp;
+}
+
+// Every n up to the limit
+size_t every_n(size_t limit) { return limit + 1; }
+
+// Result of a solve_*() for x^n (1-x)^n, or of a solve_*_nm(), as n, m and the certificate
+template <typename Result> auto symmetric_found(const Result &r) {
+  return std::apply([](size_t n, const auto &...c) { return std::make_tuple(n, n, std::array{c...}); }, r);
+}
+template <typename Result> auto asymmetric_found(const Result &r) {
+  return std::apply(
+      [](size_t n, size_t m, const auto &...c) { return std::make_tuple(n, m, std::array{c...}); }, r);
+}
+
+// visit(bounds, family) with the bounds of the integral and the Family of type `tp`
+template <typename Visit> auto visit_family(const std::string &tp, bool asymmetric, const Visit &visit) {
+  if (tp == "pi") {
+    Family<3> family{forms_pi, every_n, moments_pi, pi_enclosure, estimate_n_pi,
+                     [](size_t n, size_t m, const auto &c) {
+                       return ans_to_sympy_pi(n, m, c[0], c[1], c[2]);
+                     },
+                     [](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool nm) {
+                       return nm ? asymmetric_found(solve_pi_nm(a, b, limit, opt))
+                                 : symmetric_found(solve_pi(a, b, limit, opt));
+                     }};
+    return visit(bound_pi, family);
+  }
+  if (tp == "e") {
+    Family<2> family{forms_e, every_n, moments_e, e_enclosure, estimate_n_e,
+                     [](size_t n, size_t m, const auto &c) { return ans_to_sympy_e(n, m, c[0], c[1]); },
+                     [](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool nm) {
+                       return nm ? asymmetric_found(solve_e_nm(a, b, limit, opt))
+                                 : symmetric_found(solve_e(a, b, limit, opt));
+                     }};
+    return visit(bound_e, family);
+  }
+  if (tp == "e_power_pi") {
+    Family<2> family{forms_e_power_pi, every_n, moments_e_power_pi,
+                     [](size_t digits) { return exp_pi_enclosure(1, digits); }, estimate_n_e_power_pi,
+                     [](size_t n, size_t m, const auto &c) {
+                       return ans_to_sympy_e_power_pi(n, m, c[0], c[1]);
+                     },
+                     [](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool nm) {
+                       return nm ? asymmetric_found(solve_e_power_pi_nm(a, b, limit, opt))
+                                 : symmetric_found(solve_e_power_pi(a, b, limit, opt));
+                     }};
+    return visit(bound_e_power_pi, family);
+  }
+  if (const std::string str = match_uint("pi_power_", tp); !str.empty()) {
+    const size_t n = stoull(str), parity = (n + 1) & 1;
+    if (asymmetric)
+      throw not_implemented("Asymmetric search for pi_power_n");
+    // Only every other m is usable, so the forms are indexed by k with m = 2k + parity
+    Family<2> family{[n, parity](size_t k) { return forms_pi_power_n(n, 2 * k + parity); },
+                     [parity](size_t limit) { return limit >= parity ? (limit - parity) / 2 + 1 : 0; },
+                     nullptr,
+                     [n](size_t digits) { return pi_power_enclosure(n, digits); },
+                     nullptr,
+                     [n, parity](size_t k, size_t, const auto &c) {
+                       return ans_to_sympy_pi_power_n(n, 2 * k + parity, c[0], c[1]);
+                     },
+                     [n, parity](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool) {
+                       const auto [m, p, q] = solve_pi_power_n(a, b, n, limit, opt);
+                       const size_t k = (m - parity) / 2;
+                       return std::make_tuple(k, k, std::array{p, q});
+                     }};
+    return visit(bound_pi_power_n, family);
+  }
+  if (const std::string str = match_sint("e_power_", tp); !str.empty()) {
+    const Fraction q(str);
+    Family<2> family{[q](size_t n) { return forms_e_power_q(q, n); }, every_n,
+                     [q]() { return moments_e_power_q(q); },
+                     [q](size_t digits) { return exp_enclosure(q.numerator, q.denominator, digits); },
+                     [q](long double digits) { return estimate_n_e_power_q(q, digits); },
+                     [q](size_t n, size_t m, const auto &c) {
+                       return ans_to_sympy_e_power_q(n, m, c[0], c[1], q);
+                     },
+                     [q](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool nm) {
+                       return nm ? asymmetric_found(solve_e_power_q_nm(a, b, q, limit, opt))
+                                 : symmetric_found(solve_e_power_q(a, b, q, limit, opt));
+                     }};
+    return visit(bound_e_power_q, family);
+  }
+  if (const std::string str = match_sint("e_power_pi_", tp); !str.empty()) {
+    const Fraction q(str);
+    Family<2> family{[q](size_t n) { return forms_e_power_pi_q(q, n); }, every_n,
+                     [q]() { return moments_e_power_pi_q(q); },
+                     [q](size_t digits) { return exp_pi_enclosure(q, digits); },
+                     [q](long double digits) { return estimate_n_e_power_pi_q(q, digits); },
+                     [q](size_t n, size_t m, const auto &c) {
+                       return ans_to_sympy_e_power_pi_q(n, m, c[0], c[1], q);
+                     },
+                     [q](const Fraction &a, const Fraction &b, size_t limit, const auto &opt, bool nm) {
+                       return nm ? asymmetric_found(solve_e_power_pi_q_nm(a, b, q, limit, opt))
+                                 : symmetric_found(solve_e_power_pi_q(a, b, q, limit, opt));
+                     }};
+    return visit(bound_e_power_pi_q, family);
+  }
+  throw std::invalid_argument("Unknown type: " + tp);
+}
+
+// Bounds of the integral and the function of the certificate of one query of type `tp`, found by the
+// family's own solver
+std::pair<std::pair<std::string, std::string>, std::string>
+single_solve(const std::string &tp, const Fraction &a, const Fraction &b, size_t limit,
+             const SearchOptions &opt, bool asymmetric) {
+  return visit_family(tp, asymmetric, [&](const auto &bounds, const auto &family) {
+    const auto [n, m, cert] = family.solve(a, b, limit, opt, asymmetric);
+    return std::make_pair(bounds, family.format(n, m, cert));
+  });
+}
+
+// Bounds of the integral for queries of type `tp` in a batch, and the solver sharing its forms
+std::pair<std::pair<std::string, std::string>, BatchSolver> batch_family(const std::string &tp,
+                                                                         const BatchSettings &settings) {
+  return visit_family(tp, settings.asymmetric, [&](const auto &bounds, const auto &family) {
+    return std::make_pair(bounds, batch_solver(tp, family, settings));
+  });
+}
+
+// Bounds of the integral and the certificates of one query of type `tp`, see certificate_generator()
+std::pair<std::pair<std::string, std::string>, CertificateGenerator>
+all_certificates(const std::string &tp, const Fraction &a, const Fraction &b, const BatchSettings &settings) {
+  return visit_family(tp, settings.asymmetric, [&](const auto &bounds, const auto &family) {
+    return std::make_pair(bounds, certificate_generator(tp, family, a, b, settings.limit, settings));
+  });
+}
+
+// Extends the table of type `tp` in `dir` to every n a search up to `limit` tries, returning the number
+// of forms added
+size_t generate_table(const std::string &dir, const std::string &tp, size_t limit) {
+  return visit_family(tp, false, [&](const auto &, const auto &family) {
+    using Forms = std::decay_t<decltype(family.forms(0))>;
+    const std::string type = canonical_type(tp);
+    const size_t count = family.count(limit);
+    return extend_table<std::tuple_size_v<Forms>>(table_path(dir, type), type, count, family.forms);
+  });
+}
+
+// Queries of a batch or a server, answered by families created on first use and kept for all later
+// queries of their type. Lines may be answered concurrently.
+class Session {
+public:
+  explicit Session(BatchSettings settings) : settings(std::move(settings)) {}
+
+  // The answer to a line `<type> <B> <A> [<limit>]`: the query, then the bounds and the function of its
+  // certificate, or the error it raised; "" for a blank line. The limit may not exceed the session's, and
+  // each query has the session's timeout. The line `stats` is answered with the counters of the result
+  // cache and the peak memory.
+  std::string answer(const std::string &line) {
+    std::istringstream fields(line);
+    std::string tp, b, a, limit, rest;
+    if (!(fields >> tp))
+      return "";
+    if (tp == "stats" && !(fields >> rest))
+      return "stats : " + (settings.cache ? describe(settings.cache->stats()) : "no cache") + ", " +
+             describe_memory();
+    fields >> b >> a >> limit;
+    std::string reply = tp + " " + b + " " + a + (limit.empty() ? "" : " " + limit) + " : ";
+    try {
+      CancelToken token(std::chrono::duration_cast<CancelToken::Clock::duration>(settings.timeout));
+      CancelScope scope(settings.timeout.count() > 0 ? &token : nullptr);
+      if (a.empty() || fields >> rest)
+        throw std::invalid_argument("Expected a line `<type> <B> <A> [<limit>]`");
+      const Fraction A((BigInt(a))), B((BigInt(b)));
+      const size_t n = limit.empty() ? settings.limit : std::stoul(limit);
+      if (n > settings.limit)
+        throw std::out_of_range("Limit above the maximum of " + std::to_string(settings.limit));
+      const auto &[bounds, solve] = family(tp);
+      const std::string function = solve(A, B, n);
+      return reply + bounds.first + ", " + bounds.second + " : " + function;
+    } catch (const std::exception &e) {
+      return reply + "error : " + e.what();
+    }
+  }
+
+private:
+  using Entry = std::pair<std::pair<std::string, std::string>, BatchSolver>;
+
+  BatchSettings settings;
+  std::map<std::string, Entry> families; // Never erased, so entries can be used after unlocking
+  std::mutex lock;
+
+  // Each type is set up once, under the lock, however many connections ask for it at the same time
+  const Entry &family(const std::string &tp) {
+    const std::string type = canonical_type(tp);
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = families.find(type);
+    if (it == families.end())
+      it = families.emplace(type, batch_family(type, settings)).first;
+    return it->second;
+  }
+};
+
+// Answers each line of `in` with one line of `out`, see Session::answer(). The forms of a type are
+// computed once for all of its queries.
+void run_batch(std::istream &in, std::ostream &out, const BatchSettings &settings) {
+  Session session(settings);
+  std::string line;
+  while (std::getline(in, line))
+    if (const std::string reply = session.answer(line); !reply.empty())
+      out << reply << std::endl;
+}
+
 int main(int argc, char *argv[]) {
   using namespace std;
 
+  MemoryReport report;
   try {
     size_t limit = 64;
     string tp;
+    SearchOptions opt;
+    SearchStats stats;
+    bool asymmetric = false, batch = false;
+    string batch_file, tables, server, socket, cache_dir;
+    size_t workers = 0, wanted = 0; // Certificates to print, 0 for the answer alone
+    uint64_t cache_size = 64 << 20;
+    std::chrono::duration<double> timeout{0};
 
-    switch (argc) {
-    case 5:
-      limit = stoul(argv[4]);
-      [[fallthrough]];
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+      const string arg = argv[i];
+      if (arg.substr(0, 2) != "--") {
+        args.push_back(arg);
+      } else if (const string mode = match_option("--search", arg); !mode.empty()) {
+        if (mode == "linear")
+          opt.mode = Search::linear;
+        else if (mode == "gallop")
+          opt.mode = Search::gallop;
+        else
+          throw std::invalid_argument("Unknown search mode: " + mode);
+      } else if (arg == "--batch") {
+        batch = true;
+      } else if (const string file = match_option("--batch", arg); !file.empty()) {
+        batch = true, batch_file = file;
+      } else if (const string dir = match_option("--tables", arg); !dir.empty()) {
+        tables = dir;
+      } else if (const string path = match_option("--serve", arg); !path.empty()) {
+        server = path;
+      } else if (const string path = match_option("--connect", arg); !path.empty()) {
+        socket = path;
+      } else if (const string n = match_option("--workers", arg); !n.empty()) {
+        workers = stoul(n);
+      } else if (const string dir = match_option("--cache", arg); !dir.empty()) {
+        cache_dir = dir;
+      } else if (const string size = match_option("--cache-size", arg); !size.empty()) {
+        cache_size = parse_size(size);
+      } else if (const string seconds = match_option("--timeout", arg); !seconds.empty()) {
+        timeout = std::chrono::duration<double>(stod(seconds));
+        if (!(timeout.count() > 0))
+          throw std::invalid_argument("Expected a positive timeout: " + seconds);
+      } else if (arg == "--all") {
+        wanted = SIZE_MAX;
+      } else if (const string k = match_option("--count", arg); !k.empty()) {
+        wanted = stoul(k);
+        if (wanted == 0)
+          throw std::invalid_argument("Expected a positive count: " + k);
+      } else if (arg == "--asymmetric") {
+        asymmetric = true;
+      } else if (arg == "--no-prefilter") {
+        opt.prefilter = false;
+      } else if (arg == "--no-precheck") {
+        opt.precheck = false;
+      } else if (const string size = match_option("--max-memory", arg); !size.empty()) {
+        set_memory_budget(parse_size(size));
+        report.enabled = true;
+      } else if (arg == "--stats") {
+        opt.stats = &stats, report.enabled = true;
+      } else if (const string threads = match_option("--threads", arg); !threads.empty()) {
+        opt.threads = stoul(threads);
+      } else {
+        throw std::invalid_argument("Unknown option: " + arg);
+      }
+    }
+
+    if (wanted > 0 && (batch || !server.empty() || !socket.empty()))
+      throw std::invalid_argument("--all and --count only apply to single queries");
+
+    if (!args.empty() && args[0] == "generate") {
+      if (args.size() != 3 || tables.empty()) {
+        cerr << usage << endl;
+        return 1;
+      }
+      const size_t added = generate_table(tables, args[1], stoul(args[2]));
+      cout << "Tables   : " << table_path(tables, canonical_type(args[1])) << ", " << added << " forms added"
+           << endl;
+      return 0;
+    }
+
+    if (!server.empty()) {
+      if (args.size() > 1) {
+        cerr << usage << endl;
+        return 1;
+      }
+      if (!args.empty())
+        limit = stoul(args[0]);
+      if (workers == 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+      const auto cache = std::make_shared<ResultCache>(cached_results, cache_dir, cache_size);
+      Session session({limit, opt, asymmetric, tables, cache, timeout});
+      cerr << "Serving  : " << server << " with " << workers << " workers, limit " << limit << endl;
+      serve(server, workers, 4 * workers, [&](const string &line) { return session.answer(line); });
+      return 0;
+    }
+
+    if (!socket.empty()) {
+      LineSocket connection(connect_unix(socket));
+      auto ask = [&](const string &line) {
+        if (!connection.write_line(line))
+          throw std::runtime_error("Connection to " + socket + " lost");
+        auto reply = connection.read_line();
+        if (!reply)
+          throw std::runtime_error("Connection to " + socket + " closed");
+        return *reply;
+      };
+      if (batch) {
+        ifstream file;
+        if (!batch_file.empty()) {
+          file.open(batch_file);
+          if (!file)
+            throw std::runtime_error("Cannot open " + batch_file);
+        }
+        istream &in = batch_file.empty() ? cin : file;
+        // One line in flight at a time, so neither side blocks on a full socket buffer
+        for (string line; getline(in, line);)
+          if (line.find_first_not_of(" \t\r") != string::npos)
+            cout << ask(line) << endl;
+        return 0;
+      }
+      if (args.size() != 3 && args.size() != 4) {
+        cerr << usage << endl;
+        return 1;
+      }
+      string line = args[0] + " " + args[1] + " " + args[2] + (args.size() == 4 ? " " + args[3] : "");
+      // The reply is the query, then "<lo>, <hi> : <function>" or "error : <what>"
+      const string reply = ask(line), separator = " : ";
+      const size_t first = reply.find(separator), second = reply.find(separator, first + separator.size());
+      if (first == string::npos || second == string::npos)
+        throw std::runtime_error("Malformed reply: " + reply);
+      const string head = reply.substr(first + separator.size(), second - first - separator.size());
+      const string tail = reply.substr(second + separator.size());
+      if (head == "error") {
+        cerr << "error: " << tail << endl;
+        return 1;
+      }
+      cout << "Bounds   : " << head << endl;
+      cout << "Function : " << tail << endl;
+      return 0;
+    }
+
+    if (batch) {
+      if (args.size() > 1) {
+        cerr << usage << endl;
+        return 1;
+      }
+      if (!args.empty())
+        limit = stoul(args[0]);
+      ifstream file;
+      if (!batch_file.empty()) {
+        file.open(batch_file);
+        if (!file)
+          throw std::runtime_error("Cannot open " + batch_file);
+      }
+      const auto cache = std::make_shared<ResultCache>(cached_results, cache_dir, cache_size);
+      run_batch(batch_file.empty() ? cin : file, cout, {limit, opt, asymmetric, tables, cache, timeout});
+      if (opt.stats) {
+        cerr << "Stats    : " << stats.exact << " exact solves (" << stats.singular << " singular), "
+             << stats.prefiltered << " rejected by intervals" << endl;
+        cerr << "Cache    : " << describe(cache->stats()) << endl;
+      }
+      return 0;
+    }
+
+    switch (args.size()) {
     case 4:
-      tp = argv[1];
+      limit = stoul(args[3]);
+      [[fallthrough]];
+    case 3:
+      tp = args[0];
       break;
     default:
-      cerr << "Usage: solve <type> <B> <A> [<limit=64>]" << endl;
+      cerr << usage << endl;
       return 1;
     }
 
-    BigInt A(argv[3]), B(argv[2]);
-
-    if (tp == "pi") {
-      auto [n, a, b, c] = solve_pi(A, B, limit);
-      cout << "Bounds   : " << bound_pi.first << ", " << bound_pi.second << endl;
-      cout << "Function : " << ans_to_sympy_pi(n, n, a, b, c) << endl;
-    } else if (tp == "e") {
-      auto [n, a, b] = solve_e(A, B, limit);
-      cout << "Bounds   : " << bound_e.first << ", " << bound_e.second << endl;
-      cout << "Function : " << ans_to_sympy_e(n, n, a, b) << endl;
-    } else if (tp == "e_power_pi") {
-      auto [n, a, b] = solve_e_power_pi(A, B, limit);
-      cout << "Bounds   : " << bound_e_power_pi.first << ", " << bound_e_power_pi.second << endl;
-      cout << "Function : " << ans_to_sympy_e_power_pi(n, n, a, b) << endl;
-    } else if (const std::string str = match_uint("pi_power_", tp); !str.empty()) {
-      size_t n = stoull(str);
-      auto [m, a, b] = solve_pi_power_n(A, B, n, limit);
-      cout << "Bounds   : " << bound_pi_power_n.first << ", " << bound_pi_power_n.second << endl;
-      cout << "Function : " << ans_to_sympy_pi_power_n(n, m, a, b) << endl;
-    } else if (const std::string str = match_sint("e_power_", tp); !str.empty()) {
-      Fraction q(str);
-      auto [n, a, b] = solve_e_power_q(A, B, q, limit);
-      cout << "Bounds   : " << bound_e_power_q.first << ", " << bound_e_power_q.second << endl;
-      cout << "Function : " << ans_to_sympy_e_power_q(n, n, a, b, q) << endl;
-    } else if (const std::string str = match_sint("e_power_pi_", tp); !str.empty()) {
-      Fraction q(str);
-      auto [n, a, b] = solve_e_power_pi_q(A, B, q, limit);
-      cout << "Bounds   : " << bound_e_power_pi_q.first << ", " << bound_e_power_pi_q.second << endl;
-      cout << "Function : " << ans_to_sympy_e_power_pi_q(n, n, a, b, q) << endl;
+    // Everything from here on counts against the timeout
+    CancelToken token(std::chrono::duration_cast<CancelToken::Clock::duration>(timeout));
+    CancelScope scope(timeout.count() > 0 ? &token : nullptr);
+    BigInt A(args[2]), B(args[1]);
+    std::pair<std::string, std::string> bounds;
+    std::string function;
+
+    std::shared_ptr<ResultCache> cache;
+    if (wanted > 0) {
+      // Each certificate is printed as soon as it is found, and the search stops at the last one wanted
+      const BatchSettings settings{limit, opt, asymmetric, tables, nullptr, timeout};
+      CertificateGenerator next;
+      std::tie(bounds, next) = all_certificates(canonical_type(tp), A, B, settings);
+      size_t found = 0;
+      for (; found < wanted; ++found) {
+        const std::optional<std::string> f = next();
+        if (!f)
+          break;
+        if (found == 0)
+          cout << "Bounds   : " << bounds.first << ", " << bounds.second << endl;
+        cout << "Function : " << *f << endl;
+      }
+      if (found == 0)
+        throw std::domain_error("No solution found within the limit of " + std::to_string(limit));
+    } else if (!tables.empty() || !cache_dir.empty()) {
+      // The forms come from the table, or the result from the cache, so the query takes the batch path
+      if (!cache_dir.empty())
+        cache = std::make_shared<ResultCache>(1, cache_dir, cache_size);
+      BatchSolver solve;
+      const BatchSettings settings{limit, opt, asymmetric, tables, cache, timeout};
+      std::tie(bounds, solve) = batch_family(canonical_type(tp), settings);
+      function = solve(A, B, limit);
     } else {
-      cerr << "Unknown type: " << tp << endl;
-      return 1;
+      std::tie(bounds, function) = single_solve(tp, A, B, limit, opt, asymmetric);
+    }
+    if (wanted == 0) {
+      cout << "Bounds   : " << bounds.first << ", " << bounds.second << endl;
+      cout << "Function : " << function << endl;
+    }
+    if (opt.stats) {
+      cerr << "Stats    : " << stats.exact << " exact solves (" << stats.singular << " singular), "
+           << stats.prefiltered << " rejected by intervals" << endl;
+      if (stats.estimate)
+        cerr << "Estimate : n = " << stats.estimate << " for a relative gap of 10^-" << stats.gap_digits
+             << endl;
+      if (cache)
+        cerr << "Cache    : " << describe(cache->stats()) << endl;
     }
 
+  } catch (const timed_out &e) {
+    cerr << "timed_out: " << e.what() << endl;
+    return 4;
   } catch (const std::runtime_error &e) {
     cerr << "std::runtime_error: " << e.what() << endl;
     return 1;
@@ -109,6 +597,9 @@ int main(int argc, char *argv[]) {
   } catch (const std::logic_error &e) {
     cerr << "std::logic_error: " << e.what() << endl;
     return 3;
+  } catch (const memory_exhausted &e) {
+    cerr << "memory_exhausted: " << e.what() << endl;
+    return 5;
   } catch (const std::bad_alloc &e) {
     cerr << "std::bad_alloc: " << e.what() << endl;
     return 3;
@@ -7,9 +7,13 @@
 
 #include "except.hpp"
 #include "fraction.hpp"
+#include "memory.hpp"
 
 struct Symbol {
-  std::map<char, Fraction> variables;
+  using Variables =
+      std::map<char, Fraction, std::less<char>, CountingAllocator<std::pair<const char, Fraction>>>;
+
+  Variables variables;
 
   Symbol() = default;
   Symbol(const Fraction &value) {
@@ -58,7 +62,7 @@ struct Symbol {
 
   bool is_zero() const { return variables.size() == 0; }
 
-  const std::map<char, Fraction> &get_variables() const { return variables; }
+  const Variables &get_variables() const { return variables; }
 
   Symbol operator+() const {
     return *this; // Unary plus does not change the symbol
@@ -0,0 +1,219 @@
+#ifndef TABLES_HPP
+#define TABLES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "symbol.hpp"
+
+// Tables of the forms of a family for n = 0, ..., count - 1, as batch mode computes them, kept on disk so
+// later runs map them instead of rebuilding them and the zeta, beta and factorial values they contain.
+// All integers are in host byte order:
+//   header   "ATTNFORM", uint32 version, uint32 K, uint64 count, uint64 length of the type, the type padded
+//            with zeros to a multiple of 8 bytes
+//   offsets  uint64[count + 1], where the forms of each n start and the last ones end, relative to the body
+//   body     for each n, K symbols: uint32 terms, then for each term the uint32 name, the numerator and the
+//            denominator; an integer is int32 sign, uint32 limbs and its base-10^4 limbs, least significant
+//            first
+//   checksum uint64 FNV-1a of everything before it
+constexpr char table_magic[8] = {'A', 'T', 'T', 'N', 'F', 'O', 'R', 'M'};
+constexpr uint32_t table_version = 1;
+
+uint64_t fnv1a(const unsigned char *data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < size; ++i)
+    hash = (hash ^ data[i]) * 0x100000001b3;
+  return hash;
+}
+
+// File name of the table for `type` in `dir`; the slash of a rational parameter is not allowed in names
+std::string table_path(const std::string &dir, const std::string &type) {
+  std::string name = type;
+  for (char &c : name)
+    if (c == '/')
+      c = '_';
+  return dir + "/" + name + ".tbl";
+}
+
+// A table mapped read-only. Forms are decoded from the mapping only when asked for, so opening a table
+// costs one pass for the checksum whatever its size.
+template <size_t K> class MappedForms {
+public:
+  // Maps the table for `type` at `path`, which is empty if there is no such file. A file that is not a
+  // valid table of this type is an error rather than something to silently rebuild.
+  MappedForms(const std::string &path, const std::string &type) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      length = (size_t)st.st_size;
+      void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      data = p == MAP_FAILED ? nullptr : (const unsigned char *)p;
+    }
+    ::close(fd);
+    if (!data)
+      throw std::runtime_error("Cannot map table " + path);
+    try {
+      validate(type);
+    } catch (...) {
+      ::munmap((void *)data, length);
+      throw;
+    }
+  }
+  MappedForms(const MappedForms &) = delete;
+  MappedForms &operator=(const MappedForms &) = delete;
+  ~MappedForms() {
+    if (data)
+      ::munmap((void *)data, length);
+  }
+
+  size_t size() const { return count; }
+
+  std::array<Symbol, K> operator()(size_t n) const {
+    const unsigned char *p = entry(n), *end = entry(n + 1);
+    std::array<Symbol, K> forms;
+    for (Symbol &s : forms)
+      for (uint32_t terms = read<uint32_t>(p, end); terms > 0; --terms) {
+        const char name = (char)read<uint32_t>(p, end);
+        const BigInt num = read_int(p, end), den = read_int(p, end);
+        s.add_variable(name, Fraction::reduced(num, den));
+      }
+    return forms;
+  }
+
+  // Encoded forms of n, to be copied into an extended table
+  std::string raw(size_t n) const { return std::string((const char *)entry(n), entry(n + 1) - entry(n)); }
+
+private:
+  const unsigned char *data = nullptr;
+  size_t length = 0, count = 0;
+  const unsigned char *offsets = nullptr, *body = nullptr;
+
+  template <typename T> static T read(const unsigned char *&p, const unsigned char *end) {
+    if ((size_t)(end - p) < sizeof(T))
+      throw std::runtime_error("Truncated table entry.");
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return p += sizeof(T), value;
+  }
+
+  // The limbs are copied straight from the mapping: the body starts 8-byte aligned in the page-aligned
+  // mapping and every field is a multiple of 4 bytes long, so they are aligned for uint32_t
+  static BigInt read_int(const unsigned char *&p, const unsigned char *end) {
+    const int32_t sign = read<int32_t>(p, end);
+    const uint32_t size = read<uint32_t>(p, end);
+    if ((size_t)(end - p) / sizeof(uint32_t) < size)
+      throw std::runtime_error("Truncated table entry.");
+    const uint32_t *limbs = reinterpret_cast<const uint32_t *>(p);
+    p += size * sizeof(uint32_t);
+    BigInt r;
+    return r.set_limbs(sign, limbs, size), r;
+  }
+
+  const unsigned char *entry(size_t n) const {
+    uint64_t offset;
+    std::memcpy(&offset, offsets + n * sizeof(uint64_t), sizeof(uint64_t));
+    return body + offset;
+  }
+
+  void validate(const std::string &type) {
+    const unsigned char *p = data, *end = data + length;
+    auto fail = [](const std::string &why) { throw std::runtime_error("Invalid table: " + why); };
+    if (length < sizeof(table_magic) + sizeof(uint64_t) || std::memcmp(p, table_magic, sizeof(table_magic)))
+      fail("not a table of forms");
+    uint64_t checksum;
+    std::memcpy(&checksum, end - sizeof(uint64_t), sizeof(uint64_t));
+    end -= sizeof(uint64_t);
+    if (fnv1a(data, end - data) != checksum)
+      fail("checksum mismatch");
+    p += sizeof(table_magic);
+    if (read<uint32_t>(p, end) != table_version)
+      fail("unsupported version");
+    if (read<uint32_t>(p, end) != K)
+      fail("wrong number of forms");
+    count = read<uint64_t>(p, end);
+    const uint64_t name_length = read<uint64_t>(p, end), padded = (name_length + 7) / 8 * 8;
+    if ((uint64_t)(end - p) < padded || std::string((const char *)p, name_length) != type)
+      fail("not a table of " + type);
+    p += padded;
+    if ((uint64_t)(end - p) / sizeof(uint64_t) <= count)
+      fail("truncated offsets");
+    offsets = p, body = p + (count + 1) * sizeof(uint64_t);
+    for (size_t n = 0; n <= count; ++n) {
+      if (entry(n) > end || (n > 0 && entry(n) < entry(n - 1)))
+        fail("offsets out of order");
+      if ((entry(n) - data) % sizeof(uint32_t) != 0)
+        fail("misaligned entry"); // read_int() reads limbs in place
+    }
+  }
+};
+
+// Encoded forms, as in the body of a table
+template <size_t K> std::string encode_forms(const std::array<Symbol, K> &forms) {
+  std::string out;
+  auto put = [&](const auto &value) { out.append((const char *)&value, sizeof(value)); };
+  auto put_int = [&](const BigInt &x) {
+    put(int32_t(x.get_sign())), put(uint32_t(x.limbs().size()));
+    out.append((const char *)x.limbs().data(), x.limbs().size() * sizeof(uint32_t));
+  };
+  for (const Symbol &s : forms) {
+    put(uint32_t(s.get_variables().size()));
+    for (const auto &[name, c] : s.get_variables())
+      put(uint32_t((unsigned char)name)), put_int(c.numerator), put_int(c.denominator);
+  }
+  return out;
+}
+
+// Extends the table for `type` at `path` to n = 0, ..., count - 1, keeping the forms it already has and
+// computing the others with forms(n). The new table is written beside the old one and renamed over it, so a
+// reader never sees a partial file. Returns the number of forms added.
+template <size_t K, typename Forms>
+size_t extend_table(const std::string &path, const std::string &type, size_t count, const Forms &forms) {
+  std::vector<std::string> entries;
+  {
+    const MappedForms<K> old(path, type);
+    for (size_t n = 0; n < old.size(); ++n)
+      entries.push_back(old.raw(n));
+  }
+  const size_t kept = entries.size();
+  for (size_t n = kept; n < count; ++n)
+    entries.push_back(encode_forms<K>(forms(n)));
+
+  std::string out(table_magic, sizeof(table_magic));
+  auto put = [&](const auto &value) { out.append((const char *)&value, sizeof(value)); };
+  put(table_version), put(uint32_t(K)), put(uint64_t(entries.size())), put(uint64_t(type.size()));
+  out.append(type), out.append((8 - type.size() % 8) % 8, '\0');
+  uint64_t offset = 0;
+  put(offset);
+  for (const std::string &e : entries)
+    put(offset += e.size());
+  for (const std::string &e : entries)
+    out.append(e);
+  put(fnv1a((const unsigned char *)out.data(), out.size()));
+
+  const std::string temp = path + ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), out.size()))
+      throw std::runtime_error("Cannot write table " + temp);
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Cannot replace table " + path);
+  return entries.size() > kept ? entries.size() - kept : 0;
+}
+
+#endif // TABLES_HPP
@@ -1,51 +1,276 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
 #include "equation.hpp"
+#include "interval.hpp"
+#include "modular.hpp"
 #include "poly.hpp"
+#include "positivity.hpp"
+#include "search.hpp"
 #include "symbol.hpp"
 
 using Poly_s = Poly<Symbol>;
 
-std::pair<Fraction, Fraction> solve_ab(const Symbol &eq1, const Symbol &eq2) {
-  Fraction a1 = eq1.get_coefficient('a');
-  Fraction b1 = eq1.get_coefficient('b');
-  Fraction a2 = eq2.get_coefficient('a');
-  Fraction b2 = eq2.get_coefficient('b');
-  Fraction c1 = eq1.get_coefficient(0);
-  Fraction c2 = eq2.get_coefficient(0);
+// x^n * (1-x)^m * base, expanded directly from the binomial coefficients of (1-x)^m
+Poly_s aux_poly(size_t n, size_t m, const Poly_s &base) {
+  Poly_s window;
+  window.coeffs.resize(n + m + 1);
+  BigInt binom(1);
+  for (size_t k = 0; k <= m; ++k) {
+    window.coeffs[n + k] = Symbol(Fraction((k & 1) ? -binom : binom));
+    binom = binom * BigInt((uintmax_t)(m - k)) / BigInt((uintmax_t)(k + 1));
+  }
+  return window * base;
+}
+
+// Sum of coeffs[i] / divisor(i), where each variable is summed through rational_sum over the terms it
+// appears in
+template <typename Divisor> Symbol symbol_sum(const std::vector<Symbol> &coeffs, const Divisor &divisor) {
+  std::map<char, std::vector<std::pair<size_t, const Fraction *>>> terms;
+  for (size_t i = 0; i < coeffs.size(); ++i)
+    for (const auto &[name, coefficient] : coeffs[i].get_variables())
+      terms[name].emplace_back(i, &coefficient);
+  Symbol sum;
+  for (const auto &[name, list] : terms)
+    sum.add_variable(name, rational_sum(list.size(), [&](size_t j) {
+      const auto &[i, coefficient] = list[j];
+      return std::make_pair(coefficient->numerator, coefficient->denominator * divisor(i));
+    }));
+  return sum;
+}
+
+// Sums coeffs[i] * w(i) over the even and over the odd i, where w(i) = w(i-2) * p/q with {p, q} = ratio(i),
+// q > 0, and w(0) = w(1) = 1. Each parity is a series with rational term ratios, so binary_split() builds
+// the products as a tree and every sum is reduced once, rather than multiplying a running Fraction by
+// each ratio and taking a GCD every time.
+template <typename Ratio>
+std::array<Symbol, 2> parity_sums(const std::vector<Symbol> &coeffs, const Ratio &ratio) {
+  std::set<char> names;
+  for (const Symbol &c : coeffs)
+    for (const auto &variable : c.get_variables())
+      names.insert(variable.first);
+  std::array<Symbol, 2> sums;
+  for (size_t parity = 0; parity < std::min<size_t>(2, coeffs.size()); ++parity) {
+    const size_t count = (coeffs.size() - parity + 1) / 2;
+    for (char name : names) {
+      const Split s = binary_split(0, count, [&](size_t k) {
+        const size_t i = 2 * k + parity;
+        const Fraction c = coeffs[i].get_coefficient(name);
+        if (k == 0)
+          return SeriesTerm{c.numerator, c.denominator, 1_big, 1_big};
+        auto [p, q] = ratio(i);
+        return SeriesTerm{c.numerator, c.denominator, std::move(p), std::move(q)};
+      });
+      sums[parity].add_variable(name, Fraction(s.T, s.B * s.Q));
+    }
+  }
+  return sums;
+}
+
+// Unknowns from which modular_solve() beats bareiss(): on random systems with 20 to 400 digit entries it is
+// on par at 6 and 2.5 to 10 times faster at 10 to 24, while for 2 or 3 it is 2 to 4 times slower
+constexpr size_t modular_min_unknowns = 6;
 
-  return solve2(a1, a2, b1, b2, c1, c2);
+// Values of the variables names[0..n-1] with eqs[i] = 0 for the n equations, or nothing if the system is
+// singular. Each equation is scaled to integer coefficients by the lcm of its denominators and handed to
+// try_bareiss(), or for larger systems to try_modular_solve() with `threads` workers, so the only GCDs left
+// are the ones of the scaling and of the n final divisions.
+std::optional<std::vector<Fraction>> try_solve_linear(const std::vector<Symbol> &eqs,
+                                                      const std::string &names, size_t threads = 1) {
+  const size_t n = names.size();
+  if (eqs.size() != n)
+    throw std::invalid_argument("The system needs as many equations as unknowns.");
+  std::vector<std::vector<BigInt>> m(n, std::vector<BigInt>(n + 1));
+  for (size_t i = 0; i < n; ++i) {
+    std::vector<Fraction> row(n + 1);
+    BigInt lcm(1);
+    for (size_t j = 0; j <= n; ++j) {
+      row[j] = eqs[i].get_coefficient(j < n ? names[j] : 0);
+      lcm = lcm / Fraction::find_gcd(lcm, row[j].denominator) * row[j].denominator;
+    }
+    for (size_t j = 0; j <= n; ++j)
+      m[i][j] = row[j].numerator * (lcm / row[j].denominator);
+    m[i][n] = -m[i][n]; // The constant term moves to the right-hand side
+  }
+  auto solution = n >= modular_min_unknowns ? try_modular_solve(m, threads) : try_bareiss(std::move(m));
+  if (!solution)
+    return std::nullopt;
+  std::vector<Fraction> x;
+  for (const BigInt &numerator : solution->first)
+    x.emplace_back(numerator, solution->second);
+  return x;
+}
+
+std::vector<Fraction> solve_linear(const std::vector<Symbol> &eqs, const std::string &names,
+                                   size_t threads = 1) {
+  if (auto x = try_solve_linear(eqs, names, threads))
+    return std::move(*x);
+  throw std::domain_error("No unique solution exists for the system of equations.");
+}
+
+std::optional<std::pair<Fraction, Fraction>> try_solve_ab(const Symbol &eq1, const Symbol &eq2) {
+  if (auto x = try_solve_linear({eq1, eq2}, "ab"))
+    return std::make_pair((*x)[0], (*x)[1]);
+  return std::nullopt;
+}
+
+std::optional<std::tuple<Fraction, Fraction, Fraction>> try_solve_abc(const Symbol &eq1, const Symbol &eq2,
+                                                                      const Symbol &eq3) {
+  if (auto x = try_solve_linear({eq1, eq2, eq3}, "abc"))
+    return std::make_tuple((*x)[0], (*x)[1], (*x)[2]);
+  return std::nullopt;
+}
+
+std::pair<Fraction, Fraction> solve_ab(const Symbol &eq1, const Symbol &eq2) {
+  const std::vector<Fraction> x = solve_linear({eq1, eq2}, "ab");
+  return {x[0], x[1]};
 }
 
 std::tuple<Fraction, Fraction, Fraction> solve_abc(const Symbol &eq1, const Symbol &eq2, const Symbol &eq3) {
-  Fraction a1 = eq1.get_coefficient('a');
-  Fraction b1 = eq1.get_coefficient('b');
-  Fraction c1 = eq1.get_coefficient('c');
-  Fraction a2 = eq2.get_coefficient('a');
-  Fraction b2 = eq2.get_coefficient('b');
-  Fraction c2 = eq2.get_coefficient('c');
-  Fraction a3 = eq3.get_coefficient('a');
-  Fraction b3 = eq3.get_coefficient('b');
-  Fraction c3 = eq3.get_coefficient('c');
-  Fraction d1 = eq1.get_coefficient(0);
-  Fraction d2 = eq2.get_coefficient(0);
-  Fraction d3 = eq3.get_coefficient(0);
-
-  return solve3(a1, a2, a3, b1, b2, b3, c1, c2, c3, d1, d2, d3);
-}
-
-// Ensure a + b*x >= 0 on [0, 1]
+  const std::vector<Fraction> x = solve_linear({eq1, eq2, eq3}, "abc");
+  return {x[0], x[1], x[2]};
+}
+
+// Ensure a + b*x >= 0 on [0, 1], where a and a + b are its Bernstein coefficients
 bool ensure_nonegative(const Fraction &a, const Fraction &b) { return a >= 0 && a + b >= 0; }
 
 // Ensure a + bx + cx^2 >= 0 on [0, 1]
 bool ensure_nonegative(const Fraction &a, const Fraction &b, const Fraction &c) {
-  if (c.is_zero())
-    return ensure_nonegative(a, b);
-  if (a < 0 || a + b + c < 0)
+  return nonnegative_on_unit({a, b, c});
+}
+
+// False only if the solution of eq1 = eq2 = 0 certainly has a + b*x < 0 somewhere on [0, 1]
+bool maybe_nonegative_ab(const Symbol &eq1, const Symbol &eq2) {
+  auto a1 = to_interval(eq1.get_coefficient('a')), b1 = to_interval(eq1.get_coefficient('b'));
+  auto a2 = to_interval(eq2.get_coefficient('a')), b2 = to_interval(eq2.get_coefficient('b'));
+  auto c1 = to_interval(eq1.get_coefficient(0)), c2 = to_interval(eq2.get_coefficient(0));
+  if (!a1 || !b1 || !a2 || !b2 || !c1 || !c2)
+    return true;
+  Interval D = determinant2(*a1, *a2, *b1, *b2);
+  if (D.contains_zero())
+    return true;
+  Interval A = determinant2(*c1, *c2, *b1, *b2), B = determinant2(*a1, *a2, *c1, *c2);
+  // a = -A/D, a + b = -(A + B)/D
+  return !(-A / D).is_negative() && !(-(A + B) / D).is_negative();
+}
+
+// False only if the solution of eq1 = eq2 = eq3 = 0 certainly has a + b*x + c*x^2 < 0 somewhere on [0, 1]
+bool maybe_nonegative_abc(const Symbol &eq1, const Symbol &eq2, const Symbol &eq3) {
+  std::optional<Interval> m[3][4];
+  const Symbol *eqs[3] = {&eq1, &eq2, &eq3};
+  for (size_t i = 0; i < 3; ++i)
+    for (size_t j = 0; j < 4; ++j)
+      if (!(m[i][j] = to_interval(eqs[i]->get_coefficient(j == 3 ? 0 : char('a' + j)))))
+        return true;
+  auto det = [&](size_t x, size_t y, size_t z) {
+    return determinant3(*m[0][x], *m[1][x], *m[2][x], *m[0][y], *m[1][y], *m[2][y], *m[0][z], *m[1][z],
+                        *m[2][z]);
+  };
+  Interval D = det(0, 1, 2);
+  if (D.contains_zero())
+    return true;
+  Interval A = det(3, 1, 2), B = det(0, 3, 2), C = det(0, 1, 3);
+  // a = -A/D, b = -B/D, c = -C/D
+  if ((-A / D).is_negative() || (-(A + B + C) / D).is_negative())
     return false;
-  Fraction peak = -b / (2_frac * c);
-  return (peak <= 0 || peak >= 1) || (a + b * peak + c * peak * peak >= 0);
+  if (!(-C / D).is_positive())
+    return true;
+  // Convex: negative somewhere iff the vertex -b/(2c) is inside and 4ac - b^2 < 0 there
+  Interval peak = -B / (Interval(2) * C);
+  return !(peak.is_positive() && (Interval(1) - peak).is_positive() &&
+           (Interval(4) * A * C - B * B).is_negative());
+}
+
+// a + b*x >= 0 on [0, 1] solving eq1 = eq2 = 0, or nothing if the system is singular or the solution is
+// negative somewhere. Unless disabled, systems the interval pass rules out skip the exact solve.
+std::optional<std::tuple<Fraction, Fraction>> certify_ab(const Symbol &eq1, const Symbol &eq2,
+                                                         const SearchOptions &opt) {
+  if (opt.prefilter && !maybe_nonegative_ab(eq1, eq2)) {
+    if (opt.stats)
+      ++opt.stats->prefiltered;
+    return std::nullopt;
+  }
+  if (opt.stats)
+    ++opt.stats->exact;
+  auto solution = try_solve_ab(eq1, eq2);
+  if (!solution) {
+    if (opt.stats)
+      ++opt.stats->singular;
+    return std::nullopt;
+  }
+  auto [a, b] = *solution;
+  if (ensure_nonegative(a, b))
+    return std::make_tuple(a, b);
+  return std::nullopt;
+}
+
+// a + b*x + c*x^2 >= 0 on [0, 1] solving eq1 = eq2 = eq3 = 0, see certify_ab()
+std::optional<std::tuple<Fraction, Fraction, Fraction>> certify_abc(const Symbol &eq1, const Symbol &eq2,
+                                                                    const Symbol &eq3,
+                                                                    const SearchOptions &opt) {
+  if (opt.prefilter && !maybe_nonegative_abc(eq1, eq2, eq3)) {
+    if (opt.stats)
+      ++opt.stats->prefiltered;
+    return std::nullopt;
+  }
+  if (opt.stats)
+    ++opt.stats->exact;
+  auto solution = try_solve_abc(eq1, eq2, eq3);
+  if (!solution) {
+    if (opt.stats)
+      ++opt.stats->singular;
+    return std::nullopt;
+  }
+  auto [a, b, c] = *solution;
+  if (ensure_nonegative(a, b, c))
+    return std::make_tuple(a, b, c);
+  return std::nullopt;
+}
+
+// certify_ab() or certify_abc() on eq[0] = ... = eq[K-1] = 0, as an array
+template <size_t K>
+std::optional<std::array<Fraction, K>> certify_forms(const std::array<Symbol, K> &eq,
+                                                     const SearchOptions &opt) {
+  static_assert(K == 2 || K == 3, "Only linear and quadratic auxiliary polynomials are supported");
+  auto to_array = [](auto &...p) { return std::array<Fraction, K>{p...}; };
+  if constexpr (K == 2) {
+    if (auto cert = certify_ab(eq[0], eq[1], opt))
+      return std::apply(to_array, *cert);
+  } else {
+    if (auto cert = certify_abc(eq[0], eq[1], eq[2], opt))
+      return std::apply(to_array, *cert);
+  }
+  return std::nullopt;
+}
+
+// Rejects a + b*alpha >= 0 up front when it is certainly false, which the search would only report after
+// trying every n up to the limit. Returns the smallest n the family's model expects for the relative gap,
+// or 1 without a model, as the starting point of a galloping search.
+size_t precheck(const Fraction &a, const Fraction &b, const Constant &alpha,
+                const std::function<size_t(long double)> &estimate, const SearchOptions &opt) {
+  if (!opt.precheck)
+    return 1;
+  const Gap gap = certify_sign(a, b, alpha);
+  if (gap.sign < 0)
+    throw std::domain_error("The inequality is false: a + b*alpha < 0 for a = " + a.to_str() +
+                            ", b = " + b.to_str());
+  const size_t n = estimate && !b.is_zero() ? std::max<size_t>(estimate(gap.digits), 1) : 1;
+  if (opt.stats)
+    opt.stats->gap_digits = gap.digits, opt.stats->estimate = estimate ? n : 0;
+  return n;
 }
 
 #endif // UTILS_HPP